@@ -84,6 +84,8 @@ void Statistics::Clear()
   mFrustumTriangleTests = 0;
   mFrustumSphereTests = 0;
   mFrustumAabbTests = 0;
+
+  mGjk.Clear();
 }
 
 void Statistics::DisplayProperties(TwBar* bar)
@@ -103,6 +105,20 @@ void Statistics::DisplayProperties(TwBar* bar)
   TwAddVarRO(bar, "AabbAabbTests", TW_TYPE_INT32, &mAabbAabbTests, "");
   TwAddVarRO(bar, "SphereSphereTests", TW_TYPE_INT32, &mSphereSphereTests, "");
   TwAddVarRO(bar, "SelfCollisions", TW_TYPE_INT32, &mSelfCollisionsCount, "");
+
+  TwAddVarRO(bar, "GjkCalls", TW_TYPE_INT32, &mGjk.mCalls, "group=Gjk");
+  TwAddVarRO(bar, "GjkIterations", TW_TYPE_INT32, &mGjk.mIterations, "group=Gjk");
+  TwAddVarRO(bar, "GjkMaxIterations", TW_TYPE_INT32, &mGjk.mMaxIterations, "group=Gjk");
+  TwAddVarRO(bar, "GjkSupportCalls", TW_TYPE_INT32, &mGjk.mSupportCalls, "group=Gjk");
+  TwAddVarRO(bar, "GjkEpsilonExits", TW_TYPE_INT32, &mGjk.mEpsilonExits, "group=Gjk");
+  TwAddVarRO(bar, "GjkMaxIterationExits", TW_TYPE_INT32, &mGjk.mMaxIterationExits, "group=Gjk");
+  TwAddVarRO(bar, "GjkDegenerateSimplices", TW_TYPE_INT32, &mGjk.mDegenerateSimplices, "group=Gjk");
+  TwAddVarRO(bar, "GjkSeparatingAxisExits", TW_TYPE_INT32, &mGjk.mSeparatingAxisExits, "group=Gjk");
+  for(size_t i = 0; i < GjkStatistics::cIterationBuckets; ++i)
+  {
+    std::string name = std::string("GjkIterations ") + GjkStatistics::cIterationBucketNames[i];
+    TwAddVarRO(bar, name.c_str(), TW_TYPE_INT32, &mGjk.mIterationHistogram[i], "group=Gjk");
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -126,6 +142,8 @@ Application::Application()
   mDrawGjk = false;
   mRunGjk = false;
   mBoundSphereType = BoundingSphereType::Centroid;
+  mSurfaceAreaRotations = false;
+  mDeferBroadphaseInserts = false;
   mFrustumCull = true;
 
   mGizmos.push_back(new TranslationGizmo());
@@ -165,6 +183,7 @@ Application::Application()
   // Bind what method of bounding sphere computation is used
   mBoundingSphereTypeEnum = TwDefineEnumFromString("BoundingSphereType", "Centroid,Ritter,PCA");
   BindPropertyInGroup(mBar, Application, BoundingSphereType, int, mBoundingSphereTypeEnum, miscPropertiesGroup);
+  BindPropertyInGroup(mBar, Application, SurfaceAreaRotations, bool, TW_TYPE_BOOLCPP, miscPropertiesGroup);
 
   // Bind other misc. properties about whether or not to perform a certain task
   TwAddVarRW(mBar, "Debugging Index", TW_TYPE_INT32, &mDebuggingIndex, miscPropertiesGroup);
@@ -172,6 +191,7 @@ Application::Application()
   TwAddVarRW(mBar, "MaxIterations", TW_TYPE_INT32, &mMaxIterations, miscPropertiesGroup);
   TwAddVarRW(mBar, "FrustumCulling", TW_TYPE_BOOLCPP, &mFrustumCull, miscPropertiesGroup);
   TwAddVarRW(mBar, "Gjk", TW_TYPE_BOOLCPP, &mRunGjk, miscPropertiesGroup);
+  TwAddVarRW(mBar, "GjkRelativeOrigin", TW_TYPE_BOOLCPP, &mNarrowphase.mRelativeOrigin, miscPropertiesGroup);
   // Put all of these properties under a group that is closed by default
   TwDefine("Application/MiscProperties label=MiscProperties opened=false");
 
@@ -414,7 +434,14 @@ void Application::LoadMeshes()
   CreateCubeMesh();
   CreateCylinderMesh();
   LoadDataFiles();
-  
+
+  // Convex meshes get an adjacency graph for hill-climbing support queries, every mesh gets the
+  // structure of arrays copy for the simd scan
+  for(size_t i = 0; i < mMeshes.size(); ++i)
+  {
+    mMeshes[i]->BuildAdjacency();
+    mMeshes[i]->BuildSoaVertices();
+  }
   
   std::string meshTypes;
   for(size_t i = 0; i < mMeshes.size(); ++i)
@@ -514,6 +541,14 @@ void Application::Update(float frameTime)
 
 
   mStatistics.mSelfCollisionsCount = results.mResults.size();
+  float epsilon = 0.001f;
+  if(mRunGjk)
+  {
+    mNarrowphase.Intersect(results, mGjkCache, mMaxIterations, epsilon);
+    mStatistics.mGjk.Add(mNarrowphase.mStatistics);
+  }
+
+  // Overlap flags and debug drawing touch shared state so they stay on this thread
   for(size_t i = 0; i < results.mResults.size(); ++i)
   {
     QueryResult& result = results.mResults[i];
@@ -523,19 +558,33 @@ void Application::Update(float frameTime)
     model0->mOverlap = 1;
     model1->mOverlap = 1;
 
+    if(!mRunGjk)
+      continue;
+
+    const Gjk::BatchResult& pairResult = mNarrowphase.mResults[i];
+    if(pairResult.mIntersecting)
+      model0->mOverlap = model1->mOverlap = 2;
+    if(!mDrawGjk)
+      continue;
+
+    // Show the contact the expanding polytope finds from the simplex the workers' gjk terminated with
     ModelSupportShape shape0;
     shape0.mModel = model0;
     ModelSupportShape shape1;
     shape1.mModel = model1;
-    
+
     Gjk gjk;
-    Gjk::CsoPoint closestPoints;
-    float epsilon = 0.001f;
-    if(mRunGjk && gjk.Intersect(&shape0, &shape1, mMaxIterations, closestPoints, epsilon, mDebuggingIndex, mDrawGjk))
+    Gjk::PenetrationInfo penetration;
+    const Gjk::BatchSimplex& simplex = mNarrowphase.mSimplices[i];
+    if(pairResult.mIntersecting && gjk.Epa(&shape0, &shape1, simplex.mPoints, simplex.mSize, mMaxIterations, epsilon, penetration))
     {
-      model0->mOverlap = model1->mOverlap = 2;
+      gDebugDrawer->DrawLine(LineSegment(penetration.mPointB, penetration.mPointA)).Color(Vector4(1, 1, 0, 1));
+      gDebugDrawer->DrawPoint(penetration.mPointA).Color(Vector4(1, 0, 0, 1));
+      gDebugDrawer->DrawPoint(penetration.mPointB).Color(Vector4(0, 1, 0, 1));
     }
   }
+  // Forget pairs that stopped overlapping so stale simplices don't accumulate
+  mGjkCache.Prune();
 
   TwRefreshBar(mBar);
   int value = TwRefreshBar(mStatisticsBar);
@@ -618,8 +667,19 @@ void Application::SetBroadphaseType(const int& type)
   else if(type == SpatialPartitionTypes::NSquaredSphere)
     mDynamicBroadphase = new BoundingSphereSpatialPartition();
   else if(type == SpatialPartitionTypes::AabbTree)
-    mDynamicBroadphase = new DynamicAabbTree();
+  {
+    DynamicAabbTree* tree = new DynamicAabbTree();
+    tree->mSurfaceAreaRotations = mSurfaceAreaRotations;
+    mDynamicBroadphase = tree;
+  }
 
+  InsertAllIntoBroadphase();
+}
+
+void Application::InsertAllIntoBroadphase()
+{
+  std::vector<Model*> models;
+  std::vector<SpatialPartitionData> datas;
   for(size_t i = 0; i < mGameObjects.size(); ++i)
   {
     GameObject* gameObject = mGameObjects[i];
@@ -630,9 +690,36 @@ void Application::SetBroadphaseType(const int& type)
       data.mAabb = model->mAabb;
       data.mBoundingSphere = model->mBoundingSphere;
       data.mClientData = model;
-      mDynamicBroadphase->InsertData(model->mSpatialPartitionKey, data);
+      models.push_back(model);
+      datas.push_back(data);
     }
   }
+
+  if(mDynamicBroadphase->mType == SpatialPartitionTypes::AabbTree)
+  {
+    std::vector<SpatialPartitionKey> keys;
+    static_cast<DynamicAabbTree*>(mDynamicBroadphase)->Build(datas, keys, &mNarrowphase.GetWorkerPool());
+    for(size_t i = 0; i < models.size(); ++i)
+      models[i]->mSpatialPartitionKey = keys[i];
+  }
+  else
+  {
+    for(size_t i = 0; i < models.size(); ++i)
+      mDynamicBroadphase->InsertData(models[i]->mSpatialPartitionKey, datas[i]);
+  }
+}
+
+bool Application::GetSurfaceAreaRotations()
+{
+  return mSurfaceAreaRotations;
+}
+
+void Application::SetSurfaceAreaRotations(const bool& surfaceAreaRotations)
+{
+  mSurfaceAreaRotations = surfaceAreaRotations;
+  // Only future mutations are affected, the tree isn't rebuilt
+  if(mDynamicBroadphase->mType == SpatialPartitionTypes::AabbTree)
+    static_cast<DynamicAabbTree*>(mDynamicBroadphase)->mSurfaceAreaRotations = surfaceAreaRotations;
 }
 
 int Application::GetBoundingSphereType()
@@ -795,6 +882,9 @@ void Application::AddGameObject(GameObject* gameObject)
     model->UpdateAabb();
     model->UpdateBoundingSphere();
 
+    if(mDeferBroadphaseInserts)
+      return;
+
     SpatialPartitionData data;
     data.mAabb = model->mAabb;
     data.mBoundingSphere = model->mBoundingSphere;
@@ -806,7 +896,7 @@ void Application::AddGameObject(GameObject* gameObject)
 void Application::UpdateGameObject(GameObject* gameObject)
 {
   Model* model = gameObject->has(Model);
-  if(model != nullptr)
+  if(model != nullptr && !mDeferBroadphaseInserts)
   {
     SpatialPartitionData data;
     data.mAabb = model->mAabb;
@@ -1098,6 +1188,18 @@ void Application::OnKeyUp(unsigned int key, int x, int y)
     ChangeLevel((mCurrentLevelIndex + 1) % mLevels.size());
   else if(key == SDLK_MINUS || key == SDLK_KP_MINUS)
     ChangeLevel((mCurrentLevelIndex + mLevels.size() - 1) % mLevels.size());
+
+  // Dump the last frame's gjk counters where scripts can pick them up
+  if(key == SDLK_F2)
+  {
+    FILE* file = nullptr;
+    fopen_s(&file, "GjkStatistics.txt", "w");
+    if(file != nullptr)
+    {
+      mStatistics.mGjk.Dump(file);
+      fclose(file);
+    }
+  }
 }
 
 Math::Vector2 GetScreenPosition(int x, int y)
@@ -1199,8 +1301,12 @@ void Application::ChangeLevel(int levelIndex)
     delete obj;
   }
   mGameObjects.clear();
+  mGjkCache.Clear();
 
 
   mCurrentLevelIndex = levelIndex;
+  mDeferBroadphaseInserts = true;
   mLevels[mCurrentLevelIndex]->Load(this);
+  mDeferBroadphaseInserts = false;
+  InsertAllIntoBroadphase();
 }
@@ -18,6 +18,7 @@
 #include "Mesh.hpp"
 #include "Camera.hpp"
 #include "Gizmo.hpp"
+#include "Gjk.hpp"
 
 class Application;
 class Level
@@ -55,6 +56,9 @@ struct Statistics
   // The number of object pairs that made it through broad phase.
   // Basically how many pairs would normally go to narrow-phase (collision detection).
   size_t mSelfCollisionsCount;
+
+  // What gjk did in narrow-phase this frame. Press F2 to write it to GjkStatistics.txt.
+  GjkStatistics mGjk;
 };
 
 namespace BoundingSphereType
@@ -94,6 +98,10 @@ public:
   // What kind of computation is used to compute the bounding sphere.
   int GetBoundingSphereType();
   void SetBoundingSphereType(const int& type);
+
+  // Whether the aabb tree rebalances with surface area rotations instead of height rotations.
+  bool GetSurfaceAreaRotations();
+  void SetSurfaceAreaRotations(const bool& surfaceAreaRotations);
   
   // What level we are currently running.
   int GetLevel();
@@ -110,6 +118,8 @@ public:
 
   void AddGameObject(GameObject* gameObject);
   void UpdateGameObject(GameObject* gameObject);
+  // Puts every model into the (empty) broadphase at once. The aabb tree builds them as one batch.
+  void InsertAllIntoBroadphase();
   void DestroyGameObject(GameObject* gameObject);
 
   void DisplayCastResult(GameObject* gameObject);
@@ -176,12 +186,19 @@ public:
   TwType mLevelTypesEnum;
   TwType mBoundingSphereTypeEnum;
   int mBoundSphereType;
+  bool mSurfaceAreaRotations;
 
   int mMaxIterations;
   bool mDebugDraw;
   bool mDrawGjk;
   bool mRunGjk;
+  // Last frame's simplex for every broadphase pair (used to warm start gjk)
+  GjkPairCache mGjkCache;
+  // Resolves the broadphase pairs across worker threads
+  GjkNarrowphase mNarrowphase;
   int mCurrentLevelIndex;
+  // Set while a level loads so its objects go into the broadphase together afterwards
+  bool mDeferBroadphaseInserts;
   void ChangeLevel(int levelIndex);
 
   static Statistics mStatistics;
@@ -12801,6 +12801,411 @@ void AabbTreeSelfQueryFuzzTest50(const std::string& testName, int debuggingIndex
   } 
 }
 
+void PrintAabbTreeKeys(DynamicAabbTree& spatialPartition, std::vector<SpatialPartitionKey>& keys, FILE* file)
+{
+  if(file == NULL)
+    return;
+
+  // Each key should lead straight to the leaf holding its data, whatever rotations happened since
+  fprintf(file, "  Test Keys:\n");
+  for(size_t i = 0; i < keys.size(); ++i)
+  {
+    unsigned int node = keys[i].mUIntKey;
+    if(node == Node::cNullNode)
+    {
+      fprintf(file, "    Key(%d) Removed\n", i);
+      continue;
+    }
+
+    const Node& leaf = spatialPartition.mNodes[node];
+    fprintf(file, "    Key(%d) Leaf(%s) ClientData(%d) %s\n", i, leaf.isLeaf() ? "true" : "false",
+            (size_t)leaf.mClientData, PrintAabb(spatialPartition.mTightAabbs[node]).c_str());
+  }
+}
+
+// Inserting along a line forces several rotations on the way up
+void DynamicAabbTreeKeyTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  data.resize(8);
+  for(size_t i = 0; i < data.size(); ++i)
+  {
+    data[i].mAabb = Aabb(Vector3(2.0f * i, 0, 0), Vector3(2.0f * i + 1, 1, 1));
+    data[i].mClientData = (void*)i;
+  }
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+}
+
+// Removing, moving and re-inserting reuses freed nodes, the remaining keys must still be valid
+void DynamicAabbTreeKeyTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  data.resize(8);
+  for(size_t i = 0; i < data.size(); ++i)
+  {
+    data[i].mAabb = Aabb(Vector3(2.0f * i, 0, 0), Vector3(2.0f * i + 1, 1, 1));
+    data[i].mClientData = (void*)i;
+  }
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+
+  spatialPartition.RemoveData(keys[1]);
+  spatialPartition.RemoveData(keys[4]);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+
+  // Moving outside of the fattened aabb re-inserts the data
+  data[6].mAabb = Aabb(Vector3(-10, 5, 0), Vector3(-9, 6, 1));
+  spatialPartition.UpdateData(keys[6], data[6]);
+  // Shrinking within it only updates the tight aabb
+  data[2].mAabb = Aabb(Vector3(4.01f, 0.01f, 0.01f), Vector3(4.99f, 0.99f, 0.99f));
+  spatialPartition.UpdateData(keys[2], data[2]);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+
+  spatialPartition.InsertData(keys[1], data[1]);
+  spatialPartition.InsertData(keys[4], data[4]);
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+}
+
+// Sums the surface area of every internal node, which is what the surface area rotations try to shrink
+float GetAabbTreeSurfaceArea(const DynamicAabbTree& spatialPartition, unsigned int node)
+{
+  if(node == Node::cNullNode || spatialPartition.mNodes[node].isLeaf())
+    return 0.0f;
+
+  const Node& current = spatialPartition.mNodes[node];
+  return current.mAabb.GetSurfaceArea() + GetAabbTreeSurfaceArea(spatialPartition, current.mLeft) +
+         GetAabbTreeSurfaceArea(spatialPartition, current.mRight);
+}
+
+void PrintAabbTreeSurfaceArea(const DynamicAabbTree& spatialPartition, FILE* file)
+{
+  if(file != NULL)
+    fprintf(file, "  Surface Area: %.2f\n", GetAabbTreeSurfaceArea(spatialPartition, spatialPartition.mRoot));
+}
+
+// The largest height difference between any node's children
+int GetAabbTreeImbalance(const DynamicAabbTree& spatialPartition, unsigned int node)
+{
+  if(node == Node::cNullNode || spatialPartition.mNodes[node].isLeaf())
+    return 0;
+
+  const Node& current = spatialPartition.mNodes[node];
+  int difference = abs((int)spatialPartition.mNodes[current.mLeft].mHeight - (int)spatialPartition.mNodes[current.mRight].mHeight);
+  return std::max(difference, std::max(GetAabbTreeImbalance(spatialPartition, current.mLeft), GetAabbTreeImbalance(spatialPartition, current.mRight)));
+}
+
+void PrintAabbTreeHeight(const DynamicAabbTree& spatialPartition, FILE* file)
+{
+  if(file != NULL && spatialPartition.mRoot != Node::cNullNode)
+    fprintf(file, "  Height: %d Imbalance: %d\n", spatialPartition.mNodes[spatialPartition.mRoot].mHeight,
+            GetAabbTreeImbalance(spatialPartition, spatialPartition.mRoot));
+}
+
+void BuildScatteredAabbData(std::vector<SpatialPartitionData>& data, size_t count)
+{
+  data.resize(count);
+  for(size_t i = 0; i < count; ++i)
+  {
+    Vector3 min((float)((i * 7) % 16), (float)((i * 5) % 9), (float)((i * 3) % 4));
+    data[i].mAabb = Aabb(min, min + Vector3(1, 1, 1));
+    data[i].mClientData = (void*)i;
+  }
+}
+
+void DynamicAabbTreeSurfaceAreaRotationTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 6);
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  spatialPartition.mSurfaceAreaRotations = true;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeSurfaceArea(spatialPartition, file);
+}
+
+// The same inserts with and without surface area rotations
+void DynamicAabbTreeSurfaceAreaRotationTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 32);
+
+  std::vector<SpatialPartitionKey> heightKeys;
+  heightKeys.resize(data.size());
+  std::vector<SpatialPartitionKey> surfaceAreaKeys;
+  surfaceAreaKeys.resize(data.size());
+
+  DynamicAabbTree heightTree;
+  DynamicAabbTree surfaceAreaTree;
+  surfaceAreaTree.mSurfaceAreaRotations = true;
+  for(size_t i = 0; i < data.size(); ++i)
+  {
+    heightTree.InsertData(heightKeys[i], data[i]);
+    surfaceAreaTree.InsertData(surfaceAreaKeys[i], data[i]);
+  }
+
+  PrintAabbTreeSurfaceArea(heightTree, file);
+  PrintAabbTreeSurfaceArea(surfaceAreaTree, file);
+  // Both trees hold the same data so they must find the same pairs
+  PrintSpatialPartitionSelfQuery(heightTree, file);
+  PrintSpatialPartitionSelfQuery(surfaceAreaTree, file);
+}
+
+// Removals rotate too, and rotations must leave every key on its leaf
+void DynamicAabbTreeSurfaceAreaRotationTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 12);
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  spatialPartition.mSurfaceAreaRotations = true;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+
+  for(size_t i = 0; i < data.size(); i += 3)
+    spatialPartition.RemoveData(keys[i]);
+
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeSurfaceArea(spatialPartition, file);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+}
+
+// Sorted inserts along a line only stay shallow if the height rotations still run beside the surface area ones
+void DynamicAabbTreeSurfaceAreaRotationTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  data.resize(64);
+  for(size_t i = 0; i < data.size(); ++i)
+  {
+    data[i].mAabb = Aabb(Vector3((float)i, 0, 0), Vector3((float)i + 1, 1, 1));
+    data[i].mClientData = (void*)i;
+  }
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  spatialPartition.mSurfaceAreaRotations = true;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+
+  PrintAabbTreeHeight(spatialPartition, file);
+  PrintAabbTreeSurfaceArea(spatialPartition, file);
+}
+
+void DynamicAabbTreeBuildTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 6);
+
+  std::vector<SpatialPartitionKey> keys;
+
+  DynamicAabbTree spatialPartition;
+  spatialPartition.Build(data, keys);
+
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeSurfaceArea(spatialPartition, file);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+}
+
+// A batch built into a tree that already has data is joined to it like a single insert
+void DynamicAabbTreeBuildTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 7);
+
+  std::vector<SpatialPartitionKey> insertedKeys;
+  insertedKeys.resize(3);
+
+  DynamicAabbTree spatialPartition;
+  for(size_t i = 0; i < insertedKeys.size(); ++i)
+    spatialPartition.InsertData(insertedKeys[i], data[i]);
+
+  std::vector<SpatialPartitionData> batch(data.begin() + insertedKeys.size(), data.end());
+  std::vector<SpatialPartitionKey> batchKeys;
+  spatialPartition.Build(batch, batchKeys);
+
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeKeys(spatialPartition, insertedKeys, file);
+  PrintAabbTreeKeys(spatialPartition, batchKeys, file);
+
+  // Built leaves are removed like any other
+  spatialPartition.RemoveData(batchKeys[1]);
+  spatialPartition.RemoveData(insertedKeys[0]);
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+}
+
+// Building into a tree that had everything removed starts the node pool over
+void DynamicAabbTreeBuildTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 4);
+
+  std::vector<SpatialPartitionKey> keys;
+  keys.resize(data.size());
+
+  DynamicAabbTree spatialPartition;
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.InsertData(keys[i], data[i]);
+  for(size_t i = 0; i < data.size(); ++i)
+    spatialPartition.RemoveData(keys[i]);
+
+  std::vector<SpatialPartitionData> empty;
+  spatialPartition.Build(empty, keys);
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+
+  spatialPartition.Build(data, keys);
+  PrintSpatialPartitionStructure(spatialPartition, PrintAabbData, file, false);
+  PrintAabbTreeKeys(spatialPartition, keys, file);
+}
+
+// Splitting the build across a pool must give the same tree as building on one thread
+void DynamicAabbTreeBuildTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 500);
+
+  std::vector<SpatialPartitionKey> insertedKeys;
+  insertedKeys.resize(data.size());
+  DynamicAabbTree insertedTree;
+  for(size_t i = 0; i < data.size(); ++i)
+    insertedTree.InsertData(insertedKeys[i], data[i]);
+
+  std::vector<SpatialPartitionKey> serialKeys;
+  DynamicAabbTree serialTree;
+  serialTree.Build(data, serialKeys);
+
+  WorkerPool pool(3);
+  std::vector<SpatialPartitionKey> parallelKeys;
+  DynamicAabbTree parallelTree;
+  parallelTree.Build(data, parallelKeys, &pool);
+
+  PrintAabbTreeSurfaceArea(insertedTree, file);
+  PrintAabbTreeSurfaceArea(serialTree, file);
+  PrintAabbTreeSurfaceArea(parallelTree, file);
+
+  std::vector<SpatialPartitionQueryData> serialResults;
+  serialTree.FilloutData(serialResults);
+  std::vector<SpatialPartitionQueryData> parallelResults;
+  parallelTree.FilloutData(parallelResults);
+
+  bool matches = serialResults.size() == parallelResults.size();
+  for(size_t i = 0; matches && i < serialResults.size(); ++i)
+  {
+    matches = serialResults[i].mDepth == parallelResults[i].mDepth &&
+              serialResults[i].mClientData == parallelResults[i].mClientData &&
+              serialResults[i].mAabb.mMin == parallelResults[i].mAabb.mMin &&
+              serialResults[i].mAabb.mMax == parallelResults[i].mAabb.mMax;
+  }
+
+  bool keysMatch = true;
+  for(size_t i = 0; i < data.size(); ++i)
+    keysMatch = keysMatch && parallelTree.mNodes[parallelKeys[i].mUIntKey].mClientData == data[i].mClientData;
+
+  QueryResults insertedPairs;
+  insertedTree.SelfQuery(insertedPairs);
+  QueryResults parallelPairs;
+  parallelTree.SelfQuery(parallelPairs);
+
+  if(file != NULL)
+  {
+    fprintf(file, "  Matches Serial Build: %s\n", matches ? "true" : "false");
+    fprintf(file, "  Keys Match: %s\n", keysMatch ? "true" : "false");
+    fprintf(file, "  SelfQuery Pairs: %d %d\n", insertedPairs.mResults.size(), parallelPairs.mResults.size());
+  }
+}
+
+// Building a big batch into a small tree and a small batch into a big one. Either way the shorter side goes in
+// low enough that no node's children end up far apart in height.
+void DynamicAabbTreeBuildTest5(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  std::vector<SpatialPartitionData> data;
+  BuildScatteredAabbData(data, 1008);
+
+  std::vector<SpatialPartitionKey> insertedKeys;
+  insertedKeys.resize(data.size());
+  DynamicAabbTree insertedTree;
+  for(size_t i = 0; i < data.size(); ++i)
+    insertedTree.InsertData(insertedKeys[i], data[i]);
+  PrintAabbTreeHeight(insertedTree, file);
+
+  const size_t splits[] = { 8, 1000 };
+  for(size_t s = 0; s < 2; ++s)
+  {
+    std::vector<SpatialPartitionKey> keys;
+    keys.resize(splits[s]);
+    DynamicAabbTree spatialPartition;
+    for(size_t i = 0; i < keys.size(); ++i)
+      spatialPartition.InsertData(keys[i], data[i]);
+
+    std::vector<SpatialPartitionData> batch(data.begin() + splits[s], data.end());
+    std::vector<SpatialPartitionKey> batchKeys;
+    spatialPartition.Build(batch, batchKeys);
+    keys.insert(keys.end(), batchKeys.begin(), batchKeys.end());
+
+    bool keysMatch = true;
+    for(size_t i = 0; i < data.size(); ++i)
+      keysMatch = keysMatch && spatialPartition.mNodes[keys[i].mUIntKey].mClientData == data[i].mClientData;
+
+    QueryResults insertedPairs;
+    insertedTree.SelfQuery(insertedPairs);
+    QueryResults pairs;
+    spatialPartition.SelfQuery(pairs);
+
+    PrintAabbTreeHeight(spatialPartition, file);
+    if(file != NULL)
+    {
+      fprintf(file, "  Keys Match: %s\n", keysMatch ? "true" : "false");
+      fprintf(file, "  Pairs Match: %s\n", insertedPairs.mResults.size() == pairs.mResults.size() ? "true" : "false");
+    }
+  }
+}
+
 void RegisterAabbTreeStructureTests(AssignmentUnitTestList& list)
 {
   DeclareSimpleUnitTest(DynamicAabbTreeStructure1, list);
@@ -13028,6 +13433,29 @@ void RegisterAabbTreeSelfQueryFuzzTests(AssignmentUnitTestList& list)
   DeclareSimpleUnitTest(AabbTreeSelfQueryFuzzTest50, list);
 }
 
+void RegisterDynamicAabbTreeKeyTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(DynamicAabbTreeKeyTest1, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeKeyTest2, list);
+}
+
+void RegisterDynamicAabbTreeSurfaceAreaRotationTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(DynamicAabbTreeSurfaceAreaRotationTest1, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeSurfaceAreaRotationTest2, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeSurfaceAreaRotationTest3, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeSurfaceAreaRotationTest4, list);
+}
+
+void RegisterDynamicAabbTreeBuildTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(DynamicAabbTreeBuildTest1, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeBuildTest2, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeBuildTest3, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeBuildTest4, list);
+  DeclareSimpleUnitTest(DynamicAabbTreeBuildTest5, list);
+}
+
 void InitializeAssignment3Tests()
 {
   mTestFns.push_back(AssignmentUnitTestList());
@@ -13042,4 +13470,7 @@ void InitializeAssignment3Tests()
   RegisterDynamicAabbTreeRayCastFuzzTests(list);
   RegisterDynamicAabbTreeFrustumCastFuzzTests(list);
   RegisterAabbTreeSelfQueryFuzzTests(list);
+  RegisterDynamicAabbTreeKeyTests(list);
+  RegisterDynamicAabbTreeSurfaceAreaRotationTests(list);
+  RegisterDynamicAabbTreeBuildTests(list);
 }
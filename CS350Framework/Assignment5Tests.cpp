@@ -3121,6 +3121,987 @@ void GjkFuzzTest105(const std::string& testName, int debuggingIndex, FILE* file
   PrintGjkResults(shapeA, shapeB, 100, debuggingIndex, file, true);
 }
 
+void PrintEpaResults(SupportShape& shape1, SupportShape& shape2, FILE* file)
+{
+  // Epa's normal is only as good as the square root of its epsilon on curved shapes
+  float epsilon = 0.00001f;
+  Gjk gjk;
+  Gjk::CsoPoint closestPoint;
+  Gjk::PenetrationInfo info;
+  bool result = gjk.Intersect(&shape1, &shape2, 100, closestPoint, epsilon, -1, false);
+  if(result)
+    result = gjk.Epa(&shape1, &shape2, gjk.mSimplex, gjk.mSimplexSize, 100, epsilon, info);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+  {
+    fprintf(file, "  Result: true\n  Normal: %s\n  Depth: %s",
+      PrintVector3(info.mNormal).c_str(),
+      PrintFloat(info.mDepth).c_str());
+  }
+  else
+  {
+    fprintf(file, "  Result: false");
+  }
+  fprintf(file, "\n");
+}
+
+void EpaTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0.75f, 0, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintEpaResults(shape1, shape2, file);
+}
+
+void EpaTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(2);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0, 1.2f, 0.1f);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintEpaResults(shape1, shape2, file);
+}
+
+void EpaTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(0, 0, 1.5f);
+  shape2.mSphere.mRadius = 1.0f;
+  PrintEpaResults(shape1, shape2, file);
+}
+
+void EpaTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(0, 0.9f, 0);
+  shape2.mSphere.mRadius = 0.5f;
+  PrintEpaResults(shape1, shape2, file);
+}
+
+void EpaTest5(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(1, 0, 0);
+  shape2.mRotation = Math::ToMatrix3(Vector3(0, 0, 1), Math::cPi / 4.0f);
+  shape2.mScale = Vector3(1);
+  PrintEpaResults(shape1, shape2, file);
+}
+
+// Shape 2 is entirely inside shape 1
+void EpaTest6(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(3);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0.2f, 0, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintEpaResults(shape1, shape2, file);
+}
+
+// Apart, so there's no simplex for Epa to start from
+void EpaTest7(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0, 0, 3);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintEpaResults(shape1, shape2, file);
+}
+
+void PrintDistanceResults(SupportShape& shape1, SupportShape& shape2, FILE* file)
+{
+  float epsilon = 0.001f;
+  Gjk gjk;
+  Gjk::CsoPoint closestPoint;
+  float distance = gjk.Distance(&shape1, &shape2, 100, epsilon, closestPoint);
+
+  if(file == NULL)
+    return;
+
+  fprintf(file, "  CsoPoint: %s\n  Distance: %s\n",
+    PrintVector3(closestPoint.mCsoPoint).c_str(),
+    PrintFloat(distance).c_str());
+}
+
+void PrintDistanceWithinResults(SupportShape& shape1, SupportShape& shape2, float maxDistance, FILE* file)
+{
+  float epsilon = 0.001f;
+  Gjk gjk;
+  Gjk::CsoPoint closestPoint;
+  float distance = 0.0f;
+  bool result = gjk.DistanceWithin(&shape1, &shape2, maxDistance, 100, epsilon, distance, closestPoint);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+  {
+    fprintf(file, "  Result: true\n  Distance: %s", PrintFloat(distance).c_str());
+  }
+  else
+  {
+    fprintf(file, "  Result: false");
+  }
+  fprintf(file, "\n");
+}
+
+// The axis is whichever one was found first so only check that it really separates the shapes
+void PrintSeparatedResults(SupportShape& shape1, SupportShape& shape2, FILE* file)
+{
+  float epsilon = 0.001f;
+  Gjk gjk;
+  Vector3 separatingAxis;
+  bool result = gjk.Separated(&shape1, &shape2, 100, epsilon, separatingAxis);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+  {
+    Gjk::CsoPoint support = gjk.ComputeSupport(&shape1, &shape2, separatingAxis);
+    bool separates = Math::Dot(support.mCsoPoint, separatingAxis) < 0.0f;
+    fprintf(file, "  Result: true\n  AxisSeparates: %s", separates ? "true" : "false");
+  }
+  else
+  {
+    fprintf(file, "  Result: false");
+  }
+  fprintf(file, "\n");
+}
+
+void DistanceTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(3, 0, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintDistanceResults(shape1, shape2, file);
+}
+
+void DistanceTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(0, 3, 4);
+  shape2.mSphere.mRadius = 0.5f;
+  PrintDistanceResults(shape1, shape2, file);
+}
+
+void DistanceTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(2);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(2, 2, 2);
+  shape2.mSphere.mRadius = 0.5f;
+  PrintDistanceResults(shape1, shape2, file);
+}
+
+void DistanceTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0.5f, 0.25f, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintDistanceResults(shape1, shape2, file);
+}
+
+void DistanceWithinTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(2);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(2, 2, 2);
+  shape2.mSphere.mRadius = 0.5f;
+  PrintDistanceWithinResults(shape1, shape2, 2.0f, file);
+}
+
+void DistanceWithinTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(2);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(2, 2, 2);
+  shape2.mSphere.mRadius = 0.5f;
+  PrintDistanceWithinResults(shape1, shape2, 1.0f, file);
+}
+
+void DistanceWithinTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(100, 0, 0);
+  shape2.mSphere.mRadius = 1.0f;
+  PrintDistanceWithinResults(shape1, shape2, 5.0f, file);
+}
+
+void SeparatedTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(3, 0, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  PrintSeparatedResults(shape1, shape2, file);
+}
+
+void SeparatedTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation = Math::ToMatrix3(Vector3(1, 1, 0).Normalized(), 0.7f);
+  shape1.mScale = Vector3(1, 2, 3);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(-1, 3, 2.5f);
+  shape2.mSphere.mRadius = 0.25f;
+  PrintSeparatedResults(shape1, shape2, file);
+}
+
+void SeparatedTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(0, 1.5f, 0);
+  shape2.mSphere.mRadius = 1.0f;
+  PrintSeparatedResults(shape1, shape2, file);
+}
+
+void PrintTimeOfImpactResults(SupportShape& shape1, const Gjk::Motion& motion1, SupportShape& shape2, const Gjk::Motion& motion2,
+  float maxTime, FILE* file)
+{
+  float epsilon = 0.001f;
+  float tolerance = 0.001f;
+  Gjk gjk;
+  Gjk::ImpactInfo info;
+  bool result = gjk.TimeOfImpact(&shape1, motion1, &shape2, motion2, maxTime, tolerance, 100, 100, epsilon, info);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+  {
+    fprintf(file, "  Result: true\n  Time: %s\n  Normal: %s",
+      PrintFloat(info.mTime).c_str(),
+      PrintVector3(info.mNormal).c_str());
+  }
+  else
+  {
+    fprintf(file, "  Result: false");
+  }
+  fprintf(file, "\n");
+}
+
+void TimeOfImpactTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion1;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(10, 0, 0);
+  shape2.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion2;
+  motion2.mLinearVelocity = Vector3(-1, 0, 0);
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 10.0f, file);
+}
+
+// Both shapes move, towards each other along a diagonal
+void TimeOfImpactTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(1);
+  Gjk::Motion motion1;
+  motion1.mLinearVelocity = Vector3(1, 0.5f, 0);
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(0, 4, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  Gjk::Motion motion2;
+  motion2.mLinearVelocity = Vector3(1, -0.5f, 0);
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 10.0f, file);
+}
+
+// A thin box spinning about z into a sphere above it. It touches when 1.5 * cos(angle) = 0.5 + 0.1.
+void TimeOfImpactTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(4, 0.2f, 0.2f);
+  Gjk::Motion motion1;
+  motion1.mAngularVelocity = Vector3(0, 0, 1);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(0, 1.5f, 0);
+  shape2.mSphere.mRadius = 0.5f;
+  Gjk::Motion motion2;
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 3.0f, file);
+}
+
+// Moving past each other
+void TimeOfImpactTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion1;
+  ObbSupportShape shape2;
+  shape2.mTranslation = Vector3(-5, 3, 0);
+  shape2.mRotation.SetIdentity();
+  shape2.mScale = Vector3(1);
+  Gjk::Motion motion2;
+  motion2.mLinearVelocity = Vector3(1, 0, 0);
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 10.0f, file);
+}
+
+// Closing, but not by maxTime
+void TimeOfImpactTest5(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion1;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(10, 0, 0);
+  shape2.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion2;
+  motion2.mLinearVelocity = Vector3(-1, 0, 0);
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 5.0f, file);
+}
+
+// Already overlapping
+void TimeOfImpactTest6(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mTranslation = Vector3(0, 0, 0);
+  shape1.mRotation.SetIdentity();
+  shape1.mScale = Vector3(2);
+  Gjk::Motion motion1;
+  motion1.mLinearVelocity = Vector3(0, 1, 0);
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(1, 0, 0);
+  shape2.mSphere.mRadius = 0.5f;
+  Gjk::Motion motion2;
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 10.0f, file);
+}
+
+// Already within tolerance at time 0, the normal should still come from that first query
+void TimeOfImpactTest7(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere.mCenter = Vector3(0, 0, 0);
+  shape1.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion1;
+  SphereSupportShape shape2;
+  shape2.mSphere.mCenter = Vector3(2.0005f, 0, 0);
+  shape2.mSphere.mRadius = 1.0f;
+  Gjk::Motion motion2;
+  motion2.mLinearVelocity = Vector3(-1, 0, 0);
+  PrintTimeOfImpactResults(shape1, motion1, shape2, motion2, 10.0f, file);
+}
+
+void PrintRayCastResults(SupportShape& shape, const Ray& ray, float maxT, unsigned int maxIterations, FILE* file)
+{
+  float epsilon = 0.001f;
+  Gjk gjk;
+  float t = 0.0f;
+  Vector3 normal;
+  bool result = gjk.RayCast(&shape, ray, maxT, maxIterations, epsilon, t, normal);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+  {
+    fprintf(file, "  Result: true\n  T: %s\n  Normal: %s",
+      PrintFloat(t).c_str(),
+      PrintVector3(normal).c_str());
+  }
+  else
+  {
+    fprintf(file, "  Result: false");
+  }
+  fprintf(file, "\n");
+}
+
+void GjkRayCastTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape;
+  shape.mSphere.mCenter = Vector3(5, 0, 0);
+  shape.mSphere.mRadius = 1.0f;
+  Ray ray(Vector3(0, 0, 0), Vector3(1, 0, 0));
+  PrintRayCastResults(shape, ray, 10.0f, 100, file);
+}
+
+void GjkRayCastTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape;
+  shape.mTranslation = Vector3(0, 5, 0);
+  shape.mRotation.SetIdentity();
+  shape.mScale = Vector3(2);
+  Ray ray(Vector3(0.3f, 0, 0.2f), Vector3(0, 1, 0));
+  PrintRayCastResults(shape, ray, 10.0f, 100, file);
+}
+
+void GjkRayCastTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape;
+  shape.mTranslation = Vector3(3, 3, 0);
+  shape.mRotation = Math::ToMatrix3(Vector3(0, 0, 1), Math::cPi / 4.0f);
+  shape.mScale = Vector3(1);
+  Ray ray(Vector3(0, 0, 0), Vector3(1, 1, 0).Normalized());
+  PrintRayCastResults(shape, ray, 10.0f, 100, file);
+}
+
+// Pointing away from the shape
+void GjkRayCastTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape;
+  shape.mSphere.mCenter = Vector3(5, 0, 0);
+  shape.mSphere.mRadius = 1.0f;
+  Ray ray(Vector3(0, 0, 0), Vector3(0, 1, 0));
+  PrintRayCastResults(shape, ray, 10.0f, 100, file);
+}
+
+// The shape is hit past maxT
+void GjkRayCastTest5(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape;
+  shape.mSphere.mCenter = Vector3(5, 0, 0);
+  shape.mSphere.mRadius = 1.0f;
+  Ray ray(Vector3(0, 0, 0), Vector3(1, 0, 0));
+  PrintRayCastResults(shape, ray, 3.0f, 100, file);
+}
+
+// Starting inside the shape
+void GjkRayCastTest6(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape;
+  shape.mSphere.mCenter = Vector3(5, 0, 0);
+  shape.mSphere.mRadius = 1.0f;
+  Ray ray(Vector3(5, 0.2f, 0), Vector3(1, 0, 0));
+  PrintRayCastResults(shape, ray, 10.0f, 100, file);
+}
+
+// A ray that would hit, but one iteration isn't enough to reach the shape
+void GjkRayCastTest7(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape;
+  shape.mSphere.mCenter = Vector3(5, 0, 0);
+  shape.mSphere.mRadius = 1.0f;
+  Ray ray(Vector3(0, 0, 0), Vector3(1, 0.1f, 0).Normalized());
+  PrintRayCastResults(shape, ray, 10.0f, 1, file);
+}
+
+// A unit cube with outward facing triangles, convex so BuildAdjacency keeps its graph
+void BuildCubeMesh(Mesh& mesh)
+{
+  for(size_t i = 0; i < 8; ++i)
+    mesh.mVertices.push_back(Vector3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+
+  const size_t indices[36] = { 0, 4, 6, 0, 6, 2,  1, 3, 7, 1, 7, 5,  0, 1, 5, 0, 5, 4,
+                               2, 6, 7, 2, 7, 3,  0, 2, 3, 0, 3, 1,  4, 5, 7, 4, 7, 6 };
+  mesh.mIndices.assign(indices, indices + 36);
+  mesh.BuildAdjacency();
+}
+
+void PrintModelRayCastResults(const Vector3& translation, const Ray& ray, FILE* file, const Vector3& scale = Vector3(1))
+{
+  Mesh mesh;
+  BuildCubeMesh(mesh);
+  GameObject object(nullptr);
+  Transform* transform = new Transform();
+  transform->mTranslation = translation;
+  transform->mScale = scale;
+  Model* model = new Model();
+  model->mMesh = &mesh;
+  object.Add(transform);
+  object.Add(model);
+
+  CastResult castResult;
+  bool result = model->CastRay(ray, castResult);
+
+  if(file == NULL)
+    return;
+
+  if(result == true)
+    fprintf(file, "  Result: true\n  T: %s\n", PrintFloat(castResult.mTime).c_str());
+  else
+    fprintf(file, "  Result: false\n");
+}
+
+void GjkRayCastModelTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  Ray ray(Vector3(0.1f, 0.2f, 0), Vector3(0, 0, 1));
+  PrintModelRayCastResults(Vector3(0, 0, 5), ray, file);
+}
+
+void GjkRayCastModelTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  Ray ray(Vector3(0, 2, 0), Vector3(0, 0, 1));
+  PrintModelRayCastResults(Vector3(0, 0, 5), ray, file);
+}
+
+// Starting inside the model, the ray hits where it leaves
+void GjkRayCastModelTest3(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  Ray ray(Vector3(0.1f, 0.2f, 5), Vector3(0, 0, 1));
+  PrintModelRayCastResults(Vector3(0, 0, 5), ray, file);
+}
+
+// A large model far from the ray's start, the cast's epsilon has to grow with it
+void GjkRayCastModelTest4(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  Ray ray(Vector3(10, 20, 0), Vector3(0, 0, 1));
+  PrintModelRayCastResults(Vector3(0, 0, 5000), ray, file, Vector3(1000));
+}
+
+// A box grown by a sphere at the origin is a rounded box
+void MinkowskiSumSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape box;
+  box.mScale = Vector3(2, 2, 2);
+  box.mRotation.SetIdentity();
+  box.mTranslation = Vector3(1, 0, 0);
+  SphereSupportShape sphere;
+  sphere.mSphere.mCenter = Vector3::cZero;
+  sphere.mSphere.mRadius = 0.5f;
+  MinkowskiSumSupportShape shape;
+  shape.mShapeA = &box;
+  shape.mShapeB = &sphere;
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(-1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+}
+
+// A segment grown by a sphere is a capsule
+void MinkowskiSumSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  PointsSupportShape segment;
+  segment.mLocalSpacePoints.push_back(Vector3(0, -1, 0));
+  segment.mLocalSpacePoints.push_back(Vector3(0, 1, 0));
+  segment.mScale = Vector3(1, 1, 1);
+  segment.mRotation.SetIdentity();
+  segment.mTranslation = Vector3(0, 0, 2);
+  SphereSupportShape sphere;
+  sphere.mSphere.mCenter = Vector3::cZero;
+  sphere.mSphere.mRadius = 0.5f;
+  MinkowskiSumSupportShape shape;
+  shape.mShapeA = &segment;
+  shape.mShapeB = &sphere;
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+// The hull of two spheres is the capsule between them
+void ConvexHullSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape sphere1;
+  sphere1.mSphere.mCenter = Vector3(-2, 0, 0);
+  sphere1.mSphere.mRadius = 1.0f;
+  SphereSupportShape sphere2;
+  sphere2.mSphere.mCenter = Vector3(2, 0, 0);
+  sphere2.mSphere.mRadius = 1.0f;
+  ConvexHullSupportShape shape;
+  shape.mShapeA = &sphere1;
+  shape.mShapeB = &sphere2;
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(-1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(0, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+}
+
+// The hull of a box at two positions is the volume it sweeps between them
+void ConvexHullSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape box1;
+  box1.mScale = Vector3(1, 1, 1);
+  box1.mRotation.SetIdentity();
+  box1.mTranslation = Vector3::cZero;
+  ObbSupportShape box2 = box1;
+  box2.mTranslation = Vector3(0, 3, 0);
+  ConvexHullSupportShape shape;
+  shape.mShapeA = &box1;
+  shape.mShapeB = &box2;
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+// A unit sphere scaled along x is an ellipsoid
+void TransformedSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape sphere;
+  sphere.mSphere.mCenter = Vector3::cZero;
+  sphere.mSphere.mRadius = 1.0f;
+  TransformedSupportShape shape;
+  shape.mShape = &sphere;
+  shape.mScale = Vector3(2, 1, 1);
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(0, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+}
+
+void TransformedSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape box;
+  box.mScale = Vector3(2, 1, 1);
+  box.mRotation.SetIdentity();
+  box.mTranslation = Vector3(1, 0, 0);
+  TransformedSupportShape shape;
+  shape.mShape = &box;
+  shape.mScale = Vector3(1, 2, 1);
+  shape.mRotation = Math::ToMatrix3(Vector3(0, 0, 1), Math::DegToRad(90));
+  shape.mTranslation = Vector3(0, 0, 3);
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+void CapsuleSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  CapsuleSupportShape shape;
+  shape.mTranslation = Vector3(1, 2, 3);
+  shape.mHalfHeight = 0.5f;
+  shape.mRadius = 0.5f;
+  PrintSupportShape(shape, Vector3(0, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+  PrintSupportShape(shape, Vector3(0, -1, 0), file);
+}
+
+void CapsuleSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  CapsuleSupportShape shape;
+  shape.mTranslation = Vector3(0, 0, -2);
+  shape.mRotation = Math::ToMatrix3(Vector3(0, 0, 1), Math::DegToRad(90));
+  shape.mHalfHeight = 1.0f;
+  shape.mRadius = 0.25f;
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+void CylinderSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  CylinderSupportShape shape;
+  shape.mHalfHeight = 1.0f;
+  shape.mRadius = 0.5f;
+  PrintSupportShape(shape, Vector3(0, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+  PrintSupportShape(shape, Vector3(0, -1, 1), file);
+}
+
+void CylinderSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  CylinderSupportShape shape;
+  shape.mTranslation = Vector3(2, 0, 0);
+  shape.mRotation = Math::ToMatrix3(Vector3(1, 0, 0), Math::DegToRad(45));
+  shape.mHalfHeight = 0.5f;
+  shape.mRadius = 1.0f;
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+// Directions closer to the axis than the slant pick the apex, everything else a point on the base's rim
+void ConeSupport1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ConeSupportShape shape;
+  shape.mHalfHeight = 1.0f;
+  shape.mRadius = 1.0f;
+  PrintSupportShape(shape, Vector3(0, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 1, 0), file);
+  PrintSupportShape(shape, Vector3(1, 0, 0), file);
+  PrintSupportShape(shape, Vector3(1, -1, 0), file);
+  PrintSupportShape(shape, Vector3(0, -1, 0), file);
+}
+
+void ConeSupport2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ConeSupportShape shape;
+  shape.mTranslation = Vector3(0, 1, 1);
+  shape.mRotation = Math::ToMatrix3(Vector3(1, 0, 0), Math::DegToRad(180));
+  shape.mHalfHeight = 0.75f;
+  shape.mRadius = 0.5f;
+  PrintSupportShapeSpherical(shape, 3, 4, file);
+}
+
+// Runs one iteration so Intersect bails out, closestPoint must still be overwritten with a point on the shapes
+void PrintGjkBailoutResults(SupportShape& shape1, SupportShape& shape2, FILE* file)
+{
+  Gjk gjk;
+  Gjk::CsoPoint closestPoint;
+  closestPoint.mPointA = closestPoint.mPointB = closestPoint.mCsoPoint = Vector3(1000, 1000, 1000);
+  bool result = gjk.Intersect(&shape1, &shape2, 1, closestPoint, 0.001f, -1, false);
+
+  if(file == NULL)
+    return;
+
+  fprintf(file, "  Result: %s\n  MaxIterationExits: %d\n", result ? "true" : "false", gjk.mStatistics.mMaxIterationExits);
+  fprintf(file, "  CsoPoint: %s\n  PointA: %s\n  PointB: %s\n",
+    PrintVector3(closestPoint.mCsoPoint).c_str(),
+    PrintVector3(closestPoint.mPointA).c_str(),
+    PrintVector3(closestPoint.mPointB).c_str());
+}
+
+void GjkBailoutTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere = Sphere(Vector3(0, 0, 0), 1.0f);
+  SphereSupportShape shape2;
+  shape2.mSphere = Sphere(Vector3(5, 1, 0), 1.0f);
+  PrintGjkBailoutResults(shape1, shape2, file);
+}
+
+void GjkBailoutTest2(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  ObbSupportShape shape1;
+  shape1.mScale = Vector3(2, 2, 2);
+  shape1.mRotation = Math::ToMatrix3(Vector3(0, 1, 0), Math::DegToRad(30));
+  shape1.mTranslation = Vector3(0, 0, 0);
+  ObbSupportShape shape2;
+  shape2.mScale = Vector3(1, 1, 1);
+  shape2.mRotation = Math::ToMatrix3(Vector3(1, 0, 0), Math::DegToRad(45));
+  shape2.mTranslation = Vector3(3, 2, 1);
+  PrintGjkBailoutResults(shape1, shape2, file);
+}
+
+// Far from the world origin and bailing out every call, the re-based closest point must not drift between calls
+void GjkBailoutRelativeTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  SphereSupportShape shape1;
+  shape1.mSphere = Sphere(Vector3(10000, 0, 0), 1.0f);
+  SphereSupportShape shape2;
+  shape2.mSphere = Sphere(Vector3(10005, 1, 0), 1.0f);
+
+  Gjk gjk;
+  Gjk::CsoPoint closestPoint;
+  closestPoint.mPointA = closestPoint.mPointB = closestPoint.mCsoPoint = Vector3(1000, 1000, 1000);
+  for(size_t i = 0; i < 2; ++i)
+  {
+    bool result = gjk.IntersectRelative(&shape1, &shape2, 1, closestPoint, 0.001f);
+    if(file != NULL)
+    {
+      fprintf(file, "  Result: %s\n  PointA: %s\n  PointB: %s\n", result ? "true" : "false",
+        PrintVector3(closestPoint.mPointA).c_str(),
+        PrintVector3(closestPoint.mPointB).c_str());
+    }
+  }
+  if(file != NULL)
+    fprintf(file, "  MaxIterationExits: %d\n", gjk.mStatistics.mMaxIterationExits);
+}
+
+void AddBatchTestModel(GameObject& object, Mesh& mesh, const Vector3& translation)
+{
+  Transform* transform = new Transform();
+  transform->mTranslation = translation;
+  Model* model = new Model();
+  model->mMesh = &mesh;
+  object.Add(transform);
+  object.Add(model);
+}
+
+void PrintIntersectBatchResults(const std::vector<Gjk::BatchResult>& results, FILE* file)
+{
+  if(file == NULL)
+    return;
+
+  // Only the distance is printed, QueryResult orders each pair's models by address so which point is A can change
+  for(size_t i = 0; i < results.size(); ++i)
+  {
+    const Gjk::BatchResult& result = results[i];
+    if(!result.mHasClosestPoint)
+      fprintf(file, "  Pair %d: separated along the cached axis\n", i);
+    else if(result.mIntersecting)
+      fprintf(file, "  Pair %d: intersecting\n", i);
+    else
+      fprintf(file, "  Pair %d: Distance: %s\n", i, PrintFloat(result.mDistance).c_str());
+  }
+}
+
+// Cubes 0 and 1 overlap and cube 2 sits apart. Cube 2 has another mesh type so the batch sorts its pairs
+// after the others, the results must still come back in the pairs' order.
+void GjkIntersectBatchTest1(const std::string& testName, int debuggingIndex, FILE* file = NULL)
+{
+  PrintTestHeader(file, testName);
+
+  Mesh mesh;
+  BuildCubeMesh(mesh);
+  Mesh otherMesh;
+  BuildCubeMesh(otherMesh);
+  otherMesh.mType = 1;
+
+  GameObject object0(nullptr);
+  AddBatchTestModel(object0, otherMesh, Vector3(3, 0, 0));
+  GameObject object1(nullptr);
+  AddBatchTestModel(object1, mesh, Vector3(0, 0, 0));
+  GameObject object2(nullptr);
+  AddBatchTestModel(object2, mesh, Vector3(0.5f, 0.5f, 0));
+
+  QueryResults pairs;
+  pairs.AddResult(QueryResult(object0.mModel, object1.mModel));
+  pairs.AddResult(QueryResult(object1.mModel, object2.mModel));
+  pairs.AddResult(QueryResult(object2.mModel, object0.mModel));
+
+  Gjk gjk;
+  GjkPairCache cache;
+  std::vector<Gjk::BatchResult> results;
+  gjk.IntersectBatch(pairs, 20, 0.001f, results, &cache);
+  PrintIntersectBatchResults(results, file);
+
+  // The second frame resolves the apart pairs with their cached axes
+  gjk.IntersectBatch(pairs, 20, 0.001f, results, &cache);
+  PrintIntersectBatchResults(results, file);
+  if(file != NULL)
+    fprintf(file, "  SeparatingAxisExits: %d\n", gjk.mStatistics.mSeparatingAxisExits);
+}
+
 void RegisterPointVoronoiRegionsTests(AssignmentUnitTestList& list)
 {
   DeclareSimpleUnitTest(PointVoronoiRegions1, list);
@@ -3430,6 +4411,89 @@ void RegisterGjkFuzzTests(AssignmentUnitTestList& list)
   DeclareSimpleUnitTest(GjkFuzzTest105, list);
 }
 
+void RegisterEpaTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(EpaTest1, list);
+  DeclareSimpleUnitTest(EpaTest2, list);
+  DeclareSimpleUnitTest(EpaTest3, list);
+  DeclareSimpleUnitTest(EpaTest4, list);
+  DeclareSimpleUnitTest(EpaTest5, list);
+  DeclareSimpleUnitTest(EpaTest6, list);
+  DeclareSimpleUnitTest(EpaTest7, list);
+}
+
+void RegisterDistanceTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(DistanceTest1, list);
+  DeclareSimpleUnitTest(DistanceTest2, list);
+  DeclareSimpleUnitTest(DistanceTest3, list);
+  DeclareSimpleUnitTest(DistanceTest4, list);
+  DeclareSimpleUnitTest(DistanceWithinTest1, list);
+  DeclareSimpleUnitTest(DistanceWithinTest2, list);
+  DeclareSimpleUnitTest(DistanceWithinTest3, list);
+  DeclareSimpleUnitTest(SeparatedTest1, list);
+  DeclareSimpleUnitTest(SeparatedTest2, list);
+  DeclareSimpleUnitTest(SeparatedTest3, list);
+}
+
+void RegisterTimeOfImpactTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(TimeOfImpactTest1, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest2, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest3, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest4, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest5, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest6, list);
+  DeclareSimpleUnitTest(TimeOfImpactTest7, list);
+}
+
+void RegisterGjkRayCastTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(GjkRayCastTest1, list);
+  DeclareSimpleUnitTest(GjkRayCastTest2, list);
+  DeclareSimpleUnitTest(GjkRayCastTest3, list);
+  DeclareSimpleUnitTest(GjkRayCastTest4, list);
+  DeclareSimpleUnitTest(GjkRayCastTest5, list);
+  DeclareSimpleUnitTest(GjkRayCastTest6, list);
+  DeclareSimpleUnitTest(GjkRayCastTest7, list);
+  DeclareSimpleUnitTest(GjkRayCastModelTest1, list);
+  DeclareSimpleUnitTest(GjkRayCastModelTest2, list);
+  DeclareSimpleUnitTest(GjkRayCastModelTest3, list);
+  DeclareSimpleUnitTest(GjkRayCastModelTest4, list);
+}
+
+void RegisterSupportShapeCombinatorTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(MinkowskiSumSupport1, list);
+  DeclareSimpleUnitTest(MinkowskiSumSupport2, list);
+  DeclareSimpleUnitTest(ConvexHullSupport1, list);
+  DeclareSimpleUnitTest(ConvexHullSupport2, list);
+  DeclareSimpleUnitTest(TransformedSupport1, list);
+  DeclareSimpleUnitTest(TransformedSupport2, list);
+}
+
+void RegisterAnalyticSupportShapeTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(CapsuleSupport1, list);
+  DeclareSimpleUnitTest(CapsuleSupport2, list);
+  DeclareSimpleUnitTest(CylinderSupport1, list);
+  DeclareSimpleUnitTest(CylinderSupport2, list);
+  DeclareSimpleUnitTest(ConeSupport1, list);
+  DeclareSimpleUnitTest(ConeSupport2, list);
+}
+
+void RegisterGjkBailoutTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(GjkBailoutTest1, list);
+  DeclareSimpleUnitTest(GjkBailoutTest2, list);
+  DeclareSimpleUnitTest(GjkBailoutRelativeTest1, list);
+}
+
+void RegisterGjkIntersectBatchTests(AssignmentUnitTestList& list)
+{
+  DeclareSimpleUnitTest(GjkIntersectBatchTest1, list);
+}
+
 void InitializeAssignment5Tests()
 {
   mTestFns.push_back(AssignmentUnitTestList());
@@ -3448,4 +4512,12 @@ void InitializeAssignment5Tests()
   RegisterGjkStressTests(list);
   RegisterShapeFuzzTests(list);
   RegisterGjkFuzzTests(list);
+  RegisterEpaTests(list);
+  RegisterDistanceTests(list);
+  RegisterTimeOfImpactTests(list);
+  RegisterGjkRayCastTests(list);
+  RegisterSupportShapeCombinatorTests(list);
+  RegisterAnalyticSupportShapeTests(list);
+  RegisterGjkBailoutTests(list);
+  RegisterGjkIntersectBatchTests(list);
 }
@@ -24,133 +24,248 @@ DynamicAabbTree::~DynamicAabbTree()
 {
 }
 
+unsigned int DynamicAabbTree::AllocateNode()
+{
+  if (mFreeList == Node::cNullNode)
+  {
+    mNodes.push_back(Node());
+    mTightAabbs.push_back(Aabb());
+    return static_cast<unsigned int>(mNodes.size() - 1);
+  }
 
-void DynamicAabbTree::InsertData(SpatialPartitionKey& key, SpatialPartitionData& data)
+  unsigned int index = mFreeList;
+  mFreeList = mNodes[index].mNext;
+  mNodes[index] = Node();
+  return index;
+}
+
+void DynamicAabbTree::FreeNode(unsigned int index)
 {
-  key.mVoidKey = data.mClientData;
+  mNodes[index].mClientData = nullptr;
+  mNodes[index].mLeft = Node::cNullNode;
+  mNodes[index].mRight = Node::cNullNode;
+  mNodes[index].mNext = mFreeList;
+  mFreeList = index;
+}
 
-  Aabb fattenedAabb = data.mAabb;
+Aabb DynamicAabbTree::GetFattenedAabb(const Aabb& aabb)
+{
+  Aabb fattenedAabb = aabb;
   Vector3 fattenedValue = Vector3((fattenedAabb.GetMax() - fattenedAabb.GetMin()) * (mFatteningFactor - 1.f) * 0.5f);
   fattenedAabb.Expand(fattenedAabb.GetMin() - fattenedValue);
   fattenedAabb.Expand(fattenedAabb.GetMax() + fattenedValue);
+  return fattenedAabb;
+}
 
-  Node* newNode = new Node();
-  newNode->mAabb = fattenedAabb;
-  newNode->mClientData = data.mClientData;
-  newNode->mLeft = nullptr;
-  newNode->mRight = nullptr;
-  newNode->mHeight = 0;
+// Recomputes an internal node's aabb and height from its children. Returns
+// whether either changed.
+bool RefitNode(std::vector<Node>& nodes, unsigned int node)
+{
+  Node& current = nodes[node];
+  const Node& left = nodes[current.mLeft];
+  const Node& right = nodes[current.mRight];
 
-  if (mRoot == nullptr)
+  Aabb aabb = Aabb::Combine(left.mAabb, right.mAabb);
+  unsigned short height = static_cast<unsigned short>(1 + std::max(left.mHeight, right.mHeight));
+  if (aabb.mMin == current.mAabb.mMin && aabb.mMax == current.mAabb.mMax && height == current.mHeight)
   {
-    mRoot = newNode;
-    return;
+    return false;
   }
 
-  Node* currentNode = mRoot;
-  while (!currentNode->isLeaf())
-  {
-    Node* left = currentNode->mLeft;
-    Node* right = currentNode->mRight;
+  current.mAabb = aabb;
+  current.mHeight = height;
+  return true;
+}
 
-    Aabb combinedAabb0 = combinedAabb0.Combine(left->mAabb, newNode->mAabb);
-    Aabb combinedAabb1 = combinedAabb1.Combine(right->mAabb, newNode->mAabb);
+void DynamicAabbTree::RefitTree(unsigned int startNode)
+{
+  RefitNode(mNodes, startNode);
 
-    float cost0 = combinedAabb0.GetSurfaceArea() - left->mAabb.GetSurfaceArea();
-    float cost1 = combinedAabb1.GetSurfaceArea() - right->mAabb.GetSurfaceArea();
+  // An ancestor that comes out unchanged leaves everything above it unchanged too
+  unsigned int node = mNodes[startNode].mParent;
+  while (node != Node::cNullNode && RefitNode(mNodes, node))
+  {
+    node = mNodes[node].mParent;
+  }
+}
 
-    if (cost0 < cost1)
-    {
-      currentNode = left;
-    }
-    else
-    {
-      currentNode = right;
-    }
+// Points the parent's link at oldChild to newChild instead.
+void ReplaceChild(std::vector<Node>& nodes, unsigned int parent, unsigned int oldChild, unsigned int newChild)
+{
+  if (nodes[parent].mLeft == oldChild)
+  {
+    nodes[parent].mLeft = newChild;
+  }
+  else
+  {
+    nodes[parent].mRight = newChild;
+  }
+  nodes[newChild].mParent = parent;
+}
 
+// Whether swapping child with grandChild, leaving sibling holding child and other, keeps both levels height balanced.
+bool IsSwapBalanced(const std::vector<Node>& nodes, unsigned int child, unsigned int grandChild, unsigned int other)
+{
+  int childHeight = nodes[child].mHeight;
+  int otherHeight = nodes[other].mHeight;
+  int siblingHeight = 1 + std::max(childHeight, otherHeight);
+  return abs(childHeight - otherHeight) <= 1 && abs(static_cast<int>(nodes[grandChild].mHeight) - siblingHeight) <= 1;
+}
+
+// Finds the grandchild of node, under sibling, whose swap with child shrinks
+// sibling's surface area the most without unbalancing the tree. Returns whether there is one.
+bool FindSurfaceAreaSwap(const std::vector<Node>& nodes, unsigned int child, unsigned int sibling, unsigned int& grandChild, float& bestCost)
+{
+  const Node& siblingNode = nodes[sibling];
+  if (siblingNode.isLeaf())
+  {
+    return false;
   }
 
-  Node* newParent = new Node();
-  newParent->mLeft = currentNode;
-  newParent->mRight = newNode;
-  newParent->mAabb = newParent->mAabb.Combine(currentNode->mAabb, newNode->mAabb);
-  newParent->mParent = currentNode->mParent;
+  const Aabb& childAabb = nodes[child].mAabb;
+  float siblingArea = siblingNode.mAabb.GetSurfaceArea();
+  bool found = false;
 
-  Node* parentNode = newParent->mParent;
-  while (parentNode)
+  // Swapping child with one grandchild leaves sibling holding child and the other grandchild
+  float cost = Aabb::Combine(childAabb, nodes[siblingNode.mRight].mAabb).GetSurfaceArea() - siblingArea;
+  if (cost < bestCost && IsSwapBalanced(nodes, child, siblingNode.mLeft, siblingNode.mRight))
+  {
+    bestCost = cost;
+    grandChild = siblingNode.mLeft;
+    found = true;
+  }
+  cost = Aabb::Combine(childAabb, nodes[siblingNode.mLeft].mAabb).GetSurfaceArea() - siblingArea;
+  if (cost < bestCost && IsSwapBalanced(nodes, child, siblingNode.mRight, siblingNode.mLeft))
   {
-    parentNode = parentNode->mParent;
+    bestCost = cost;
+    grandChild = siblingNode.mRight;
+    found = true;
   }
+  return found;
+}
 
-  if (currentNode == mRoot)
+void DynamicAabbTree::RotateForSurfaceArea(unsigned int node)
+{
+  unsigned int left = mNodes[node].mLeft;
+  unsigned int right = mNodes[node].mRight;
+
+  // Node's own aabb never changes, so only the sibling's area matters
+  float bestCost = 0.0f;
+  unsigned int child = Node::cNullNode;
+  unsigned int grandChild = Node::cNullNode;
+  if (FindSurfaceAreaSwap(mNodes, left, right, grandChild, bestCost))
   {
-    mRoot = newParent;
+    child = left;
   }
-  else
+  if (FindSurfaceAreaSwap(mNodes, right, left, grandChild, bestCost))
+  {
+    child = right;
+  }
+  if (child == Node::cNullNode)
   {
-    if (currentNode->mParent->mLeft == currentNode)
+    return;
+  }
+
+  unsigned int sibling = mNodes[grandChild].mParent;
+  ReplaceChild(mNodes, node, child, grandChild);
+  ReplaceChild(mNodes, sibling, grandChild, child);
+  RefitTree(sibling);
+}
+
+// Walks down from node towards the child whose aabb grows the least to hold aabb, stopping at the first
+// node no taller than height (a leaf for a single insert). The new data is linked in beside that node.
+unsigned int FindInsertSibling(const std::vector<Node>& nodes, unsigned int node, const Aabb& aabb, unsigned short height)
+{
+  while (!nodes[node].isLeaf() && nodes[node].mHeight > height)
+  {
+    const Node& left = nodes[nodes[node].mLeft];
+    const Node& right = nodes[nodes[node].mRight];
+
+    Aabb combinedAabb0 = Aabb::Combine(left.mAabb, aabb);
+    Aabb combinedAabb1 = Aabb::Combine(right.mAabb, aabb);
+
+    float cost0 = combinedAabb0.GetSurfaceArea() - left.mAabb.GetSurfaceArea();
+    float cost1 = combinedAabb1.GetSurfaceArea() - right.mAabb.GetSurfaceArea();
+
+    if (cost0 < cost1)
     {
-      currentNode->mParent->mLeft = newParent;
+      node = nodes[node].mLeft;
     }
     else
     {
-      currentNode->mParent->mRight = newParent;
+      node = nodes[node].mRight;
     }
   }
+  return node;
+}
 
-  currentNode->mParent = newParent;
-  newNode->mParent = newParent;
+void DynamicAabbTree::InsertData(SpatialPartitionKey& key, SpatialPartitionData& data)
+{
+  Aabb fattenedAabb = GetFattenedAabb(data.mAabb);
 
-  UpdateTree();
-  BalanceTree(newParent);
+  unsigned int newNode = AllocateNode();
+  mNodes[newNode].mAabb = fattenedAabb;
+  mTightAabbs[newNode] = data.mAabb;
+  mNodes[newNode].mClientData = data.mClientData;
 
-  key.mVoidKey = newNode->mClientData;
-}
+  // The key is the leaf's index. Rotations only relink internal nodes so the
+  // leaf stays valid until it is removed.
+  key.mUIntKey = newNode;
 
-Node* DynamicAabbTree::FindLeaf(Node* node, SpatialPartitionKey& key)
-{
-  if (node == nullptr)
+  if (mRoot == Node::cNullNode)
   {
-    return nullptr;
+    mRoot = newNode;
+    return;
   }
 
-  if (node->mClientData == key.mVoidKey && node->mHeight == 0)
-  {
-    return node;
-  }
+  unsigned int currentNode = FindInsertSibling(mNodes, mRoot, fattenedAabb, 0);
 
-  Node* left = FindLeaf(node->mLeft, key);
-  if (left != nullptr)
+  // Allocating may grow the pool, so only take references afterwards
+  unsigned int newParent = AllocateNode();
+  Node& parent = mNodes[newParent];
+  Node& current = mNodes[currentNode];
+  parent.mLeft = currentNode;
+  parent.mRight = newNode;
+  parent.mAabb = Aabb::Combine(current.mAabb, fattenedAabb);
+  parent.mParent = current.mParent;
+
+  if (currentNode == mRoot)
   {
-    return left;
+    mRoot = newParent;
   }
-  Node* right = FindLeaf(node->mRight, key);
-  if (right != nullptr)
+  else
   {
-    return right;
+    Node& grandParent = mNodes[current.mParent];
+    if (grandParent.mLeft == currentNode)
+    {
+      grandParent.mLeft = newParent;
+    }
+    else
+    {
+      grandParent.mRight = newParent;
+    }
   }
 
-  return nullptr;
+  current.mParent = newParent;
+  mNodes[newNode].mParent = newParent;
+
+  RefitTree(newParent);
+  BalanceTree(newParent);
 }
 
 void DynamicAabbTree::UpdateData(SpatialPartitionKey& key, SpatialPartitionData& data)
 {
-  Node* mCurrent = mRoot;
-  key.mVoidKey = data.mClientData;
-
-  Node* target = FindLeaf(mCurrent, key);
+  unsigned int target = key.mUIntKey;
 
-  if (target == nullptr)
+  if (target == Node::cNullNode)
   {
     return;
   }
 
-  Aabb fattenedAabb = data.mAabb;
-  Vector3 fattenedValue = Vector3((fattenedAabb.GetMax() - fattenedAabb.GetMin()) * (mFatteningFactor - 1.f) * 0.5f);
-  fattenedAabb.Expand(fattenedAabb.GetMin() - fattenedValue);
-  fattenedAabb.Expand(fattenedAabb.GetMax() + fattenedValue);
+  Aabb fattenedAabb = GetFattenedAabb(data.mAabb);
+  mTightAabbs[target] = data.mAabb;
 
-  if (!target->mAabb.Contains(fattenedAabb))
+  if (!mNodes[target].mAabb.Contains(fattenedAabb))
   {
     RemoveData(key);
     InsertData(key, data);
@@ -159,422 +274,667 @@ void DynamicAabbTree::UpdateData(SpatialPartitionKey& key, SpatialPartitionData&
 
 void DynamicAabbTree::RemoveData(SpatialPartitionKey& key)
 {
-  Node* node = FindLeaf(mRoot, key);
-  Node* remainNode;
-  if (node->mClientData == key.mVoidKey && node->mHeight == 0)
+  unsigned int node = key.mUIntKey;
+  if (node == Node::cNullNode)
   {
-    if (node == mRoot)
-    {
-      delete node;
-      mRoot = nullptr;
-
-    }
-    else if (node->mParent == mRoot)
-    {
-      if (node->mParent->mLeft->mClientData == key.mVoidKey)
-      {
-        Node* parentNode = node->mParent;
-        delete parentNode->mLeft;
-        parentNode->mLeft = nullptr;
-        mRoot = parentNode->mRight;
-        delete parentNode;
-        parentNode = nullptr;
+    return;
+  }
+  key.mUIntKey = Node::cNullNode;
 
-      }
-      else
-      {
-        Node* parentNode = node->mParent;
-        delete parentNode->mRight;
-        parentNode->mRight = nullptr;
-        mRoot = parentNode->mLeft;
-        delete parentNode;
-        parentNode = nullptr;
+  if (node == mRoot)
+  {
+    FreeNode(node);
+    mRoot = Node::cNullNode;
+    return;
+  }
 
-      }
-    }
-    else if (node->mParent->mLeft->mClientData == key.mVoidKey)
-    {
-      Node* parentNode = node->mParent;
-      delete parentNode->mLeft;
-      parentNode->mLeft = nullptr;
-      parentNode->mRight->mParent = parentNode->mParent;
-      if (parentNode->mParent->mLeft == parentNode)
-      {
-        parentNode->mParent->mLeft = parentNode->mRight;
-      }
-      else
-      {
-        parentNode->mParent->mRight = parentNode->mRight;
-      }
-      remainNode = parentNode->mRight;
-      delete parentNode;
-      parentNode = nullptr;
+  // The sibling takes the parent's place, and the parent goes away with the leaf
+  unsigned int parentNode = mNodes[node].mParent;
+  unsigned int grandParentNode = mNodes[parentNode].mParent;
+  unsigned int remainNode = mNodes[parentNode].mLeft == node ? mNodes[parentNode].mRight : mNodes[parentNode].mLeft;
 
-      UpdateTree();
-      BalanceTree(remainNode->mParent);
-    }
-    else
-    {
-      Node* parentNode = node->mParent;
+  FreeNode(node);
+  FreeNode(parentNode);
 
-      delete parentNode->mRight;
-      parentNode->mRight = nullptr;
-      parentNode->mLeft->mParent = parentNode->mParent;
-      if (parentNode->mParent->mLeft == parentNode)
-      {
-        parentNode->mParent->mLeft = parentNode->mLeft;
-      }
-      else
-      {
-        parentNode->mParent->mRight = parentNode->mLeft;
-      }
-      remainNode = parentNode->mLeft;
-      delete parentNode;
-      parentNode = nullptr;
+  mNodes[remainNode].mParent = grandParentNode;
+  if (grandParentNode == Node::cNullNode)
+  {
+    mRoot = remainNode;
+    return;
+  }
 
-      UpdateTree();
-      BalanceTree(remainNode->mParent);
-    }
+  if (mNodes[grandParentNode].mLeft == parentNode)
+  {
+    mNodes[grandParentNode].mLeft = remainNode;
+  }
+  else
+  {
+    mNodes[grandParentNode].mRight = remainNode;
   }
+
+  RefitTree(grandParentNode);
+  BalanceTree(grandParentNode);
 }
 
-void DynamicAabbTree::BalanceTree(Node* startNode)
+void DynamicAabbTree::BalanceTree(unsigned int startNode)
 {
-  if (abs(static_cast<int>(startNode->mLeft->mHeight) - static_cast<int>(startNode->mRight->mHeight)) >= 2)
+  Node& start = mNodes[startNode];
+  if (abs(static_cast<int>(mNodes[start.mLeft].mHeight) - static_cast<int>(mNodes[start.mRight].mHeight)) >= 2)
   {
-    Node* grandParentNode = startNode->mParent;
-    Node* parentNode = startNode;
-    Node* pivotNode;
+    unsigned int grandParentNode = start.mParent;
+    unsigned int parentNode = startNode;
+    unsigned int pivotNode;
     bool isLeftPivot;
-    if (startNode->mLeft->mHeight < startNode->mRight->mHeight)
+    if (mNodes[start.mLeft].mHeight < mNodes[start.mRight].mHeight)
     {
-      pivotNode = startNode->mRight;
+      pivotNode = start.mRight;
       isLeftPivot = false;
     }
     else
     {
-      pivotNode = startNode->mLeft;
+      pivotNode = start.mLeft;
       isLeftPivot = true;
     }
-    Node* smallNode;
+    Node& pivot = mNodes[pivotNode];
+    unsigned int smallNode;
     bool isLeftSmall;
-    if (pivotNode->mLeft->mHeight < pivotNode->mRight->mHeight)
+    if (mNodes[pivot.mLeft].mHeight < mNodes[pivot.mRight].mHeight)
     {
-      smallNode = pivotNode->mLeft;
+      smallNode = pivot.mLeft;
       isLeftSmall = true;
     }
     else
     {
-      smallNode = pivotNode->mRight;
+      smallNode = pivot.mRight;
       isLeftSmall = false;
     }
 
-    if (grandParentNode)
+    if (grandParentNode != Node::cNullNode)
     {
-      if (grandParentNode->mLeft == parentNode)
+      Node& grandParent = mNodes[grandParentNode];
+      if (grandParent.mLeft == parentNode)
       {
-        grandParentNode->mLeft = pivotNode;
+        grandParent.mLeft = pivotNode;
       }
       else
       {
-        grandParentNode->mRight = pivotNode;
+        grandParent.mRight = pivotNode;
       }
-      pivotNode->mParent = grandParentNode;
+      pivot.mParent = grandParentNode;
     }
     else
     {
       mRoot = pivotNode;
-      pivotNode->mParent = nullptr;
+      pivot.mParent = Node::cNullNode;
     }
 
     if (isLeftSmall)
     {
-      pivotNode->mLeft = parentNode;
+      pivot.mLeft = parentNode;
     }
     else
     {
-      pivotNode->mRight = parentNode;
+      pivot.mRight = parentNode;
     }
-    parentNode->mParent = pivotNode;
+    start.mParent = pivotNode;
 
     if (isLeftPivot)
     {
-      parentNode->mLeft = smallNode;
+      start.mLeft = smallNode;
     }
     else
     {
-      parentNode->mRight = smallNode;
+      start.mRight = smallNode;
     }
-    smallNode->mParent = parentNode;
+    mNodes[smallNode].mParent = parentNode;
 
-    UpdateTree();
+    // The old parent's children changed, and the pivot's children changed
+    // with it, so both are refit before walking on from the pivot
+    RefitNode(mNodes, parentNode);
+    RefitTree(pivotNode);
 
   }
-  else if (startNode == mRoot)
+  else
   {
-    UpdateTree();
-    return;
+    // Heights are balanced here, so surface area rotations (kept balanced themselves) can only tighten the tree
+    if (mSurfaceAreaRotations)
+    {
+      RotateForSurfaceArea(startNode);
+    }
+    if (startNode == mRoot)
+    {
+      return;
+    }
   }
 
-  BalanceTree(startNode->mParent);
+  BalanceTree(start.mParent);
 
 }
 
-void UpdateAabb(Node* node)
+// A batch of leaves being built into a subtree top-down. Every range of leaves [begin, end) owns the
+// 2 * (end - begin) - 1 nodes starting at its root's index, its left half the ones right after the root
+// and its right half the rest. Separate ranges never touch the same nodes, keys or part of mOrder, so
+// they can be built on separate threads.
+struct SahBuilder
 {
-  if (node == nullptr) return;
-
-  UpdateAabb(node->mLeft);
-  UpdateAabb(node->mRight);
-
-  if (!node->isLeaf())
+  // One entry per leaf
+  std::vector<Aabb> mAabbs;
+  std::vector<Vector3> mCentroids;
+  const std::vector<SpatialPartitionData>* mData;
+  // Leaf indices, partitioned in place as ranges are split
+  std::vector<unsigned int> mOrder;
+
+  std::vector<Node>* mNodes;
+  std::vector<Aabb>* mTightAabbs;
+  std::vector<SpatialPartitionKey>* mKeys;
+
+  // A range of leaves left to be built by a worker
+  struct Task
+  {
+    size_t mBegin;
+    size_t mEnd;
+    unsigned int mNode;
+    unsigned int mParent;
+  };
+  // Ranges no bigger than this are deferred to mTasks instead of being split
+  size_t mTaskSize;
+  std::vector<Task> mTasks;
+  // Internal nodes split before the tasks were handed out, in pre-order
+  std::vector<unsigned int> mTopNodes;
+};
+
+static const size_t cSahBins = 16;
+
+// Aabb::Combine without going through Vector3's checked subscripts, since binning calls this once per leaf per axis.
+void GrowAabb(Aabb& aabb, const Aabb& other)
+{
+  for (size_t i = 0; i < 3; ++i)
   {
-    node->mAabb = node->mAabb.Combine(node->mLeft->mAabb, node->mRight->mAabb);
+    aabb.mMin.array[i] = std::min(aabb.mMin.array[i], other.mMin.array[i]);
+    aabb.mMax.array[i] = std::max(aabb.mMax.array[i], other.mMax.array[i]);
   }
 }
 
-int UpdateHeight(Node* node)
+size_t GetSahBin(float value, float min, float scale)
 {
-  if (node == nullptr) return -1;
+  size_t bin = static_cast<size_t>((value - min) * scale);
+  return std::min(bin, cSahBins - 1);
+}
 
-  int leftHeight = UpdateHeight(node->mLeft);
-  int rightHeight = UpdateHeight(node->mRight);
-  node->mHeight = 1 + std::max(leftHeight, rightHeight);
+// Bins the centroids along the axis they're most spread out on and splits the range between the bins
+// with the lowest surface area cost. Returns the first index of the right half. Ranges with every
+// centroid in the same spot are split in the middle.
+size_t PartitionSahRange(SahBuilder& builder, size_t begin, size_t end)
+{
+  Aabb centroidBounds;
+  for (size_t i = begin; i < end; ++i)
+  {
+    const Vector3& centroid = builder.mCentroids[builder.mOrder[i]];
+    GrowAabb(centroidBounds, Aabb(centroid, centroid));
+  }
+  Vector3 extent = centroidBounds.mMax - centroidBounds.mMin;
 
-  return node->mHeight;
+  size_t axis = 0;
+  if (extent.y > extent.array[axis])
+  {
+    axis = 1;
+  }
+  if (extent.z > extent.array[axis])
+  {
+    axis = 2;
+  }
+  if (extent.array[axis] <= 0.0f)
+  {
+    return (begin + end) / 2;
+  }
+
+  float min = centroidBounds.mMin.array[axis];
+  float scale = cSahBins / extent.array[axis];
+  size_t counts[cSahBins] = {};
+  Aabb bounds[cSahBins];
+  for (size_t i = begin; i < end; ++i)
+  {
+    unsigned int leaf = builder.mOrder[i];
+    size_t bin = GetSahBin(builder.mCentroids[leaf].array[axis], min, scale);
+    ++counts[bin];
+    GrowAabb(bounds[bin], builder.mAabbs[leaf]);
+  }
+
+  // Sweep from the right first so each split's cost can be finished off by the left sweep
+  float rightAreas[cSahBins];
+  size_t rightCounts[cSahBins];
+  Aabb rightBounds;
+  size_t rightCount = 0;
+  for (size_t bin = cSahBins - 1; bin > 0; --bin)
+  {
+    GrowAabb(rightBounds, bounds[bin]);
+    rightCount += counts[bin];
+    rightAreas[bin] = rightCount != 0 ? rightBounds.GetSurfaceArea() : 0.0f;
+    rightCounts[bin] = rightCount;
+  }
+
+  // The extent is non-zero so the first and last bins both hold something and every split is valid
+  float bestCost = Math::PositiveMax();
+  size_t bestSplit = 1;
+  Aabb leftBounds;
+  size_t leftCount = 0;
+  for (size_t split = 1; split < cSahBins; ++split)
+  {
+    GrowAabb(leftBounds, bounds[split - 1]);
+    leftCount += counts[split - 1];
+    if (leftCount == 0 || rightCounts[split] == 0)
+    {
+      continue;
+    }
+
+    float cost = leftBounds.GetSurfaceArea() * leftCount + rightAreas[split] * rightCounts[split];
+    if (cost < bestCost)
+    {
+      bestCost = cost;
+      bestSplit = split;
+    }
+  }
+
+  std::vector<unsigned int>::iterator mid = std::partition(builder.mOrder.begin() + begin, builder.mOrder.begin() + end,
+    [&](unsigned int leaf) { return GetSahBin(builder.mCentroids[leaf].array[axis], min, scale) < bestSplit; });
+  return mid - builder.mOrder.begin();
 }
 
-void DynamicAabbTree::UpdateTree()
+// Builds the leaves [begin, end) into the subtree rooted at node. When deferring, ranges small enough
+// for a task are queued instead and their ancestors are left for the caller to refit.
+void BuildSahRange(SahBuilder& builder, size_t begin, size_t end, unsigned int node, unsigned int parent, bool defer)
 {
-  UpdateAabb(mRoot);
-  UpdateHeight(mRoot);
+  std::vector<Node>& nodes = *builder.mNodes;
+  nodes[node].mParent = parent;
+
+  if (end - begin == 1)
+  {
+    unsigned int leaf = builder.mOrder[begin];
+    nodes[node].mAabb = builder.mAabbs[leaf];
+    (*builder.mTightAabbs)[node] = (*builder.mData)[leaf].mAabb;
+    nodes[node].mClientData = (*builder.mData)[leaf].mClientData;
+    (*builder.mKeys)[leaf].mUIntKey = node;
+    return;
+  }
+
+  if (defer && end - begin <= builder.mTaskSize)
+  {
+    SahBuilder::Task task = { begin, end, node, parent };
+    builder.mTasks.push_back(task);
+    return;
+  }
+
+  size_t mid = PartitionSahRange(builder, begin, end);
+  nodes[node].mLeft = node + 1;
+  nodes[node].mRight = node + 2 * static_cast<unsigned int>(mid - begin);
+  if (defer)
+  {
+    builder.mTopNodes.push_back(node);
+  }
+
+  BuildSahRange(builder, begin, mid, nodes[node].mLeft, node, defer);
+  BuildSahRange(builder, mid, end, nodes[node].mRight, node, defer);
+  if (!defer)
+  {
+    RefitNode(nodes, node);
+  }
 }
 
-void DebugDrawNode(Node* node, int level, const Math::Matrix4& transform, const Vector4& color, int bitMask, int depth)
+void DynamicAabbTree::Build(std::vector<SpatialPartitionData>& data, std::vector<SpatialPartitionKey>& keys, WorkerPool* pool)
 {
-  if (level == -1)
+  keys.resize(data.size());
+  if (data.empty())
   {
-    DebugShape& aabbDrawer = gDebugDrawer->DrawAabb(node->mAabb);
-    aabbDrawer.SetTransform(transform);
-    aabbDrawer.Color(color);
-    aabbDrawer.SetMaskBit(bitMask);
-    if (node->mHeight == 0)
+    return;
+  }
+
+  size_t count = data.size();
+  SahBuilder builder;
+  builder.mAabbs.resize(count);
+  builder.mCentroids.resize(count);
+  builder.mOrder.resize(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    builder.mAabbs[i] = GetFattenedAabb(data[i].mAabb);
+    builder.mCentroids[i] = builder.mAabbs[i].GetCenter();
+    builder.mOrder[i] = static_cast<unsigned int>(i);
+  }
+  builder.mData = &data;
+  builder.mNodes = &mNodes;
+  builder.mTightAabbs = &mTightAabbs;
+  builder.mTaskSize = 0;
+  builder.mKeys = &keys;
+
+  // An empty tree only has free nodes left, so start the pool over
+  if (mRoot == Node::cNullNode)
+  {
+    mNodes.clear();
+    mTightAabbs.clear();
+    mFreeList = Node::cNullNode;
+  }
+
+  // The batch gets its own contiguous block of nodes (not pulled from the free list)
+  // so the pool is never resized while the subtree is being built
+  unsigned int subtreeRoot = static_cast<unsigned int>(mNodes.size());
+  mNodes.resize(mNodes.size() + 2 * count - 1);
+  mTightAabbs.resize(mNodes.size());
+
+  if (pool == nullptr || pool->GetWorkerCount() == 1)
+  {
+    BuildSahRange(builder, 0, count, subtreeRoot, Node::cNullNode, false);
+  }
+  else
+  {
+    // Split on this thread until there are enough subtrees to keep every worker busy
+    builder.mTaskSize = std::max<size_t>(count / (pool->GetWorkerCount() * 4), 64);
+    BuildSahRange(builder, 0, count, subtreeRoot, Node::cNullNode, true);
+    pool->ParallelFor(builder.mTasks.size(), 1, [&builder](size_t begin, size_t end, size_t)
     {
-      return;
+      for (size_t i = begin; i < end; ++i)
+      {
+        const SahBuilder::Task& task = builder.mTasks[i];
+        BuildSahRange(builder, task.mBegin, task.mEnd, task.mNode, task.mParent, false);
+      }
+    });
+
+    // Children come after their parents in pre-order, so walking it backwards refits bottom up
+    for (size_t i = builder.mTopNodes.size(); i > 0; --i)
+    {
+      RefitNode(mNodes, builder.mTopNodes[i - 1]);
     }
-    DebugDrawNode(node->mLeft, level, transform, color, bitMask, depth + 1);
-    DebugDrawNode(node->mRight, level, transform, color, bitMask, depth + 1);
   }
-  else if (depth < level + 1)
+
+  if (mRoot == Node::cNullNode)
+  {
+    mRoot = subtreeRoot;
+    return;
+  }
+
+  // The shorter of the old tree and the batch goes in beside a node of about its own height in the taller one,
+  // picked by the same descent as a single insert. Linking it beside the root instead could leave a height
+  // difference far bigger than the rotations on the way back up can fix.
+  unsigned int tallRoot = mRoot;
+  unsigned int shortRoot = subtreeRoot;
+  if (mNodes[shortRoot].mHeight > mNodes[tallRoot].mHeight)
+  {
+    std::swap(tallRoot, shortRoot);
+  }
+  mRoot = tallRoot;
+  unsigned int sibling = FindInsertSibling(mNodes, tallRoot, mNodes[shortRoot].mAabb, mNodes[shortRoot].mHeight);
+
+  unsigned int newParent = AllocateNode();
+  unsigned int parent = mNodes[sibling].mParent;
+  mNodes[newParent].mLeft = sibling;
+  mNodes[newParent].mRight = shortRoot;
+  mNodes[newParent].mParent = parent;
+  if (parent == Node::cNullNode)
+  {
+    mRoot = newParent;
+  }
+  else
   {
-    DebugShape& aabbDrawer = gDebugDrawer->DrawAabb(node->mAabb);
+    ReplaceChild(mNodes, parent, sibling, newParent);
+  }
+  mNodes[sibling].mParent = newParent;
+  mNodes[shortRoot].mParent = newParent;
+
+  RefitTree(newParent);
+  BalanceTree(newParent);
+}
+
+void DebugDrawNode(const std::vector<Node>& nodes, unsigned int node, int level, const Math::Matrix4& transform, const Vector4& color, int bitMask, int depth)
+{
+  if (level == -1 || depth < level + 1)
+  {
+    DebugShape& aabbDrawer = gDebugDrawer->DrawAabb(nodes[node].mAabb);
     aabbDrawer.SetTransform(transform);
     aabbDrawer.Color(color);
     aabbDrawer.SetMaskBit(bitMask);
-    if (node->mHeight == 0)
+    if (nodes[node].mHeight == 0)
     {
       return;
     }
-    DebugDrawNode(node->mLeft, level, transform, color, bitMask, depth + 1);
-    DebugDrawNode(node->mRight, level, transform, color, bitMask, depth + 1);
-  }
-  else
-  {
-    return;
+    DebugDrawNode(nodes, nodes[node].mLeft, level, transform, color, bitMask, depth + 1);
+    DebugDrawNode(nodes, nodes[node].mRight, level, transform, color, bitMask, depth + 1);
   }
 }
 
 void DynamicAabbTree::DebugDraw(int level, const Math::Matrix4& transform, const Vector4& color, int bitMask)
 {
-  if (mRoot == nullptr)
+  if (mRoot == Node::cNullNode)
   {
     return;
   }
-  DebugDrawNode(mRoot, level, transform, color, bitMask, 0);
+  DebugDrawNode(mNodes, mRoot, level, transform, color, bitMask, 0);
 }
 
-void CastRayNode(Node* node, const Ray& ray, CastResults& results)
+void CastRayNode(const std::vector<Node>& nodes, unsigned int node, const Ray& ray, CastResults& results)
 {
-  if (node == nullptr)
+  if (node == Node::cNullNode)
   {
     return;
   }
   float t = 0.0f;
 
-  if (RayAabb(ray.mStart, ray.mDirection, node->mAabb.GetMin(), node->mAabb.GetMax(), t))
+  if (RayAabb(ray.mStart, ray.mDirection, nodes[node].mAabb.GetMin(), nodes[node].mAabb.GetMax(), t))
   {
-    if (node->mHeight == 0)
+    if (nodes[node].mHeight == 0)
     {
       CastResult result;
-      result.mClientData = node->mClientData;
+      result.mClientData = nodes[node].mClientData;
       result.mTime = t;
       results.AddResult(result);
     }
     else
     {
-      CastRayNode(node->mLeft, ray, results);
-      CastRayNode(node->mRight, ray, results);
+      CastRayNode(nodes, nodes[node].mLeft, ray, results);
+      CastRayNode(nodes, nodes[node].mRight, ray, results);
     }
   }
 }
 
 void DynamicAabbTree::CastRay(const Ray& ray, CastResults& results)
 {
-  if (mRoot == nullptr)
+  if (mRoot == Node::cNullNode)
+  {
+    return;
+  }
+  CastRayNode(mNodes, mRoot, ray, results);
+}
+
+void CastShapeNode(const std::vector<Node>& nodes, const std::vector<Aabb>& tightAabbs, unsigned int node, Gjk& gjk, const SupportShape& shape, const Vector3& sweep, const Aabb& sweptAabb,
+  CastResults& results)
+{
+  if (node == Node::cNullNode)
+  {
+    return;
+  }
+  const Aabb& aabb = nodes[node].mAabb;
+  if (!AabbAabb(sweptAabb.mMin, sweptAabb.mMax, aabb.mMin, aabb.mMax))
+  {
+    return;
+  }
+
+  if (nodes[node].mHeight == 0)
+  {
+    // The fattened aabb only decides what to visit, hits are against the client's own bounds
+    float t = 0.0f;
+    if (ShapeCastAabb(gjk, shape, sweep, tightAabbs[node], t))
+    {
+      CastResult result;
+      result.mClientData = nodes[node].mClientData;
+      result.mTime = t;
+      results.AddResult(result);
+    }
+  }
+  else
+  {
+    CastShapeNode(nodes, tightAabbs, nodes[node].mLeft, gjk, shape, sweep, sweptAabb, results);
+    CastShapeNode(nodes, tightAabbs, nodes[node].mRight, gjk, shape, sweep, sweptAabb, results);
+  }
+}
+
+void DynamicAabbTree::CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results)
+{
+  if (mRoot == Node::cNullNode)
   {
     return;
   }
-  CastRayNode(mRoot, ray, results);
+  // Only nodes the shape passes through on the way can be hit
+  Aabb startAabb = shape.GetAabb();
+  Aabb sweptAabb = Aabb::Combine(startAabb, Aabb(startAabb.mMin + sweep, startAabb.mMax + sweep));
+  // One solver for every leaf, it's too big to build per leaf
+  Gjk gjk;
+  CastShapeNode(mNodes, mTightAabbs, mRoot, gjk, shape, sweep, sweptAabb, results);
 }
 
-void FrustumCastNode_Aux(Node* node, CastResults& results)
+void FrustumCastNode_Aux(const std::vector<Node>& nodes, unsigned int node, CastResults& results)
 {
-  if (node == nullptr)
+  if (node == Node::cNullNode)
   {
     return;
   }
-  if (node->mHeight == 0)
+  if (nodes[node].mHeight == 0)
   {
     CastResult result;
-    result.mClientData = node->mClientData;
+    result.mClientData = nodes[node].mClientData;
     results.AddResult(result);
   }
   else
   {
-    FrustumCastNode_Aux(node->mLeft, results);
-    FrustumCastNode_Aux(node->mRight, results);
+    FrustumCastNode_Aux(nodes, nodes[node].mLeft, results);
+    FrustumCastNode_Aux(nodes, nodes[node].mRight, results);
   }
 }
 
-void FrustumCastNode(Node* node, const Frustum& frustum, CastResults& results)
+void FrustumCastNode(std::vector<Node>& nodes, unsigned int node, const Frustum& frustum, CastResults& results)
 {
-  if (node == nullptr)
+  if (node == Node::cNullNode)
   {
     return;
   }
-  IntersectionType::Type type = FrustumAabb(frustum.GetPlanes(), node->mAabb.GetMin(), node->mAabb.GetMax(), node->mLastAxis);
+  size_t lastAxis = nodes[node].mLastAxis;
+  IntersectionType::Type type = FrustumAabb(frustum.GetPlanes(), nodes[node].mAabb.GetMin(), nodes[node].mAabb.GetMax(), lastAxis);
+  nodes[node].mLastAxis = static_cast<unsigned short>(lastAxis);
 
   if (type == IntersectionType::Inside)
   {
-    FrustumCastNode_Aux(node, results);
+    FrustumCastNode_Aux(nodes, node, results);
   }
   else if (type == IntersectionType::Overlaps)
   {
-    if (node->mHeight == 0)
+    if (nodes[node].mHeight == 0)
     {
       CastResult result;
-      result.mClientData = node->mClientData;
+      result.mClientData = nodes[node].mClientData;
       results.AddResult(result);
     }
     else
     {
-      if (node->mHeight == 0)
-      {
-        results.AddResult(CastResult(node->mClientData));
-        return;
-      }
-      FrustumCastNode(node->mLeft, frustum, results);
-      FrustumCastNode(node->mRight, frustum, results);
+      FrustumCastNode(nodes, nodes[node].mLeft, frustum, results);
+      FrustumCastNode(nodes, nodes[node].mRight, frustum, results);
     }
   }
 }
 
 void DynamicAabbTree::CastFrustum(const Frustum& frustum, CastResults& results)
 {
-  if (mRoot == nullptr)
+  if (mRoot == Node::cNullNode)
   {
     return;
   }
-  FrustumCastNode(mRoot, frustum, results);
+  FrustumCastNode(mNodes, mRoot, frustum, results);
 }
 
-void QueryNode(Node* left, Node* right, QueryResults& results);
+void QueryNode(const std::vector<Node>& nodes, unsigned int left, unsigned int right, QueryResults& results);
 
-void SplitNode(Node* left, Node* right, QueryResults& results)
+void SplitNode(const std::vector<Node>& nodes, unsigned int left, unsigned int right, QueryResults& results)
 {
-  if (left->mHeight == 0)
+  const Node& leftNode = nodes[left];
+  const Node& rightNode = nodes[right];
+  if (leftNode.mHeight == 0)
   {
-    QueryNode(left, right->mLeft, results);
-    QueryNode(left, right->mRight, results);
+    QueryNode(nodes, left, rightNode.mLeft, results);
+    QueryNode(nodes, left, rightNode.mRight, results);
   }
-  else if (right->mHeight == 0)
+  else if (rightNode.mHeight == 0)
   {
-    QueryNode(left->mLeft, right, results);
-    QueryNode(left->mRight, right, results);
+    QueryNode(nodes, leftNode.mLeft, right, results);
+    QueryNode(nodes, leftNode.mRight, right, results);
   }
   else
   {
-    if (left->mAabb.GetVolume() < right->mAabb.GetVolume())
+    if (leftNode.mAabb.GetVolume() < rightNode.mAabb.GetVolume())
     {
-      QueryNode(left, right->mLeft, results);
-      QueryNode(left, right->mRight, results);
+      QueryNode(nodes, left, rightNode.mLeft, results);
+      QueryNode(nodes, left, rightNode.mRight, results);
     }
     else
     {
-      QueryNode(left->mLeft, right, results);
-      QueryNode(left->mRight, right, results);
+      QueryNode(nodes, leftNode.mLeft, right, results);
+      QueryNode(nodes, leftNode.mRight, right, results);
     }
   }
 }
 
-void QueryNode(Node* left, Node* right, QueryResults& results)
+void QueryNode(const std::vector<Node>& nodes, unsigned int left, unsigned int right, QueryResults& results)
 {
-  if (!AabbAabb(left->mAabb.GetMin(), left->mAabb.GetMax(), right->mAabb.GetMin(), right->mAabb.GetMax()))
+  const Node& leftNode = nodes[left];
+  const Node& rightNode = nodes[right];
+  if (!AabbAabb(leftNode.mAabb.GetMin(), leftNode.mAabb.GetMax(), rightNode.mAabb.GetMin(), rightNode.mAabb.GetMax()))
   {
     return;
   }
 
-  if (left->mHeight == 0 && right->mHeight == 0)
+  if (leftNode.mHeight == 0 && rightNode.mHeight == 0)
   {
-    results.AddResult(QueryResult(left->mClientData, right->mClientData));
+    results.AddResult(QueryResult(leftNode.mClientData, rightNode.mClientData));
     return;
   }
 
-  SplitNode(left, right, results);
+  SplitNode(nodes, left, right, results);
 }
 
-void QueryNode(Node* node, QueryResults& results)
+void QueryNode(const std::vector<Node>& nodes, unsigned int node, QueryResults& results)
 {
-  if (node == nullptr)
+  if (node == Node::cNullNode)
   {
     return;
   }
-  if (node->mHeight == 0)
+  if (nodes[node].mHeight == 0)
   {
     return;
   }
-  QueryNode(node->mLeft, results);
-  QueryNode(node->mRight, results);
-  QueryNode(node->mLeft, node->mRight, results);
+  QueryNode(nodes, nodes[node].mLeft, results);
+  QueryNode(nodes, nodes[node].mRight, results);
+  QueryNode(nodes, nodes[node].mLeft, nodes[node].mRight, results);
 }
 
 void DynamicAabbTree::SelfQuery(QueryResults& results)
 {
-  if (mRoot == nullptr)
+  if (mRoot == Node::cNullNode)
   {
     return;
   }
-  QueryNode(mRoot, results);
+  QueryNode(mNodes, mRoot, results);
 }
 
 void DynamicAabbTree::FilloutData(std::vector<SpatialPartitionQueryData>& results) const
 {
-  Node* mCurrent = mRoot;
-  FilloutDataNode(mCurrent, results, 0);
+  FilloutDataNode(mRoot, results, 0);
 }
 
-void DynamicAabbTree::FilloutDataNode(Node* node, std::vector<SpatialPartitionQueryData>& results, int depth) const
+void DynamicAabbTree::FilloutDataNode(unsigned int node, std::vector<SpatialPartitionQueryData>& results, int depth) const
 {
-  if (node == nullptr)
+  if (node == Node::cNullNode)
   {
     return;
   }
   SpatialPartitionQueryData data;
-  data.mAabb = node->mAabb;
-  data.mClientData = node->mClientData;
+  data.mAabb = mNodes[node].mAabb;
+  data.mClientData = mNodes[node].mClientData;
   data.mDepth = depth;
   results.push_back(data);
-  FilloutDataNode(node->mLeft, results, depth + 1);
-  FilloutDataNode(node->mRight, results, depth + 1);
+  FilloutDataNode(mNodes[node].mLeft, results, depth + 1);
+  FilloutDataNode(mNodes[node].mRight, results, depth + 1);
 }
-
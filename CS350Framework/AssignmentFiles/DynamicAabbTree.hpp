@@ -12,7 +12,10 @@ End Header -------------------------------------------------------*/
 
 #include "SpatialPartition.hpp"
 #include "Shapes.hpp"
+#include "WorkerPool.hpp"
 
+// Nodes live in the tree's node pool and refer to each other by index. Free
+// nodes are chained through mNext, which shares storage with mParent.
 class Node
 {
 public:
@@ -21,35 +24,33 @@ public:
   {
     mAabb = Aabb();
     mClientData = nullptr;
-    mLeft = nullptr;
-    mRight = nullptr;
-    mParent = nullptr;
+    mParent = cNullNode;
+    mLeft = cNullNode;
+    mRight = cNullNode;
     mHeight = 0;
     mLastAxis = 0;
   }
 
-  Node(SpatialPartitionData& data)
-  {
-    mAabb = data.mAabb;
-    mClientData = data.mClientData;
-    mLeft = nullptr;
-    mRight = nullptr;
-    mParent = nullptr;
-    mHeight = 0;
-    mLastAxis = 0;
-  }
+  static const unsigned int cNullNode = 0xFFFFFFFF;
 
   Aabb mAabb;
   void* mClientData;
-  Node* mLeft = nullptr;
-  Node* mRight = nullptr;
-  Node* mParent = nullptr;
-  size_t mHeight = 0;
-  size_t mLastAxis = 0;
-
-  bool isLeaf() const { return mLeft == nullptr && mRight == nullptr; }
+  union
+  {
+    unsigned int mParent;
+    unsigned int mNext;
+  };
+  unsigned int mLeft;
+  unsigned int mRight;
+  unsigned short mHeight;
+  unsigned short mLastAxis;
+
+  bool isLeaf() const { return mLeft == cNullNode && mRight == cNullNode; }
 };
 
+// Traversals touch every node they visit, so anything only some nodes need lives outside of Node
+StaticAssert(NodeSize, sizeof(Node) <= 48, "Node should stay at or below 48 bytes");
+
 /******Student:Assignment3******/
 /// You must implement a dynamic aabb tree as we discussed in class.
 class DynamicAabbTree : public SpatialPartition
@@ -63,22 +64,44 @@ public:
   void UpdateData(SpatialPartitionKey& key, SpatialPartitionData& data) override;
   void RemoveData(SpatialPartitionKey& key) override;
 
-  Node* FindLeaf(Node* node, SpatialPartitionKey& key);
+  // Inserts a whole batch at once by building it top-down with binned surface area splits. A non-empty tree and
+  // the batch are then joined like a single insert, the shorter one linked in beside a node of its height in the other. keys[i] is filled out with data[i]'s key. Given a pool, the subtrees
+  // below the first few splits are built in parallel.
+  void Build(std::vector<SpatialPartitionData>& data, std::vector<SpatialPartitionKey>& keys, WorkerPool* pool = nullptr);
 
-  void BalanceTree(Node* startNode);
-  void UpdateTree();
+  void BalanceTree(unsigned int startNode);
+  // Refits startNode and then its ancestors, stopping at the first one whose aabb and height are unchanged.
+  void RefitTree(unsigned int startNode);
+  // Swaps a child of node with a grandchild on the other side when that shrinks the tree's total surface area
+  // and leaves both levels height balanced.
+  void RotateForSurfaceArea(unsigned int node);
+
+  unsigned int AllocateNode();
+  void FreeNode(unsigned int index);
 
   void DebugDraw(int level, const Math::Matrix4& transform, const Vector4& color = Vector4(1), int bitMask = 0) override;
 
   void CastRay(const Ray& ray, CastResults& results) override;
   void CastFrustum(const Frustum& frustum, CastResults& results) override;
+  void CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results) override;
 
   void SelfQuery(QueryResults& results) override;
 
   void FilloutData(std::vector<SpatialPartitionQueryData>& results) const override;
-  void FilloutDataNode(Node* node, std::vector<SpatialPartitionQueryData>& results, int depth) const;
+  void FilloutDataNode(unsigned int node, std::vector<SpatialPartitionQueryData>& results, int depth) const;
   static const float mFatteningFactor;
-
-  Node* mRoot = nullptr;
+  static Aabb GetFattenedAabb(const Aabb& aabb);
+
+  // Every node of the tree, including freed ones waiting on mFreeList.
+  std::vector<Node> mNodes;
+  // The aabb the client gave each leaf before it was fattened, indexed like mNodes (internal
+  // nodes' entries are unused). Queries that report hits on a leaf test against this instead of mAabb.
+  std::vector<Aabb> mTightAabbs;
+  unsigned int mFreeList = Node::cNullNode;
+  unsigned int mRoot = Node::cNullNode;
+  // After the height rotations, also try a surface area rotation at each ancestor
+  // while walking up from a modified node (only ones that keep it height balanced).
+  // Off by default since it changes the tree structure the unit tests expect.
+  bool mSurfaceAreaRotations = false;
 
 };
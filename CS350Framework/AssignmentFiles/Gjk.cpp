@@ -10,8 +10,119 @@ Creation date: 04.25.2024
 End Header -------------------------------------------------------*/
 
 #include "Precompiled.hpp"
+#include <typeinfo>
 
-float u, v, w, t;
+// Below this a simplex (or polytope) feature is treated as collapsed.
+static const float cDegenerateEpsilon = 1e-6f;
+// Relative to the size of the terms involved, below this a triangle's area or a tetrahedron's volume is treated as flat.
+static const float cFlatEpsilon = 1e-5f;
+
+//-----------------------------------------------------------------------------GjkStatistics
+GjkStatistics::GjkStatistics()
+{
+  Clear();
+}
+
+void GjkStatistics::Clear()
+{
+  mCalls = 0;
+  mIterations = 0;
+  mMaxIterations = 0;
+  mSupportCalls = 0;
+  mEpsilonExits = 0;
+  mMaxIterationExits = 0;
+  mDegenerateSimplices = 0;
+  mSeparatingAxisExits = 0;
+  for (size_t i = 0; i < cIterationBuckets; ++i)
+  {
+    mIterationHistogram[i] = 0;
+  }
+}
+
+void GjkStatistics::Add(const GjkStatistics& rhs)
+{
+  mCalls += rhs.mCalls;
+  mIterations += rhs.mIterations;
+  mMaxIterations = Math::Max(mMaxIterations, rhs.mMaxIterations);
+  mSupportCalls += rhs.mSupportCalls;
+  mEpsilonExits += rhs.mEpsilonExits;
+  mMaxIterationExits += rhs.mMaxIterationExits;
+  mDegenerateSimplices += rhs.mDegenerateSimplices;
+  mSeparatingAxisExits += rhs.mSeparatingAxisExits;
+  for (size_t i = 0; i < cIterationBuckets; ++i)
+  {
+    mIterationHistogram[i] += rhs.mIterationHistogram[i];
+  }
+}
+
+void GjkStatistics::Dump(FILE* file) const
+{
+  fprintf(file, "GjkCalls %zu\n", mCalls);
+  fprintf(file, "GjkIterations %zu\n", mIterations);
+  fprintf(file, "GjkMaxIterations %zu\n", mMaxIterations);
+  fprintf(file, "GjkSupportCalls %zu\n", mSupportCalls);
+  fprintf(file, "GjkEpsilonExits %zu\n", mEpsilonExits);
+  fprintf(file, "GjkMaxIterationExits %zu\n", mMaxIterationExits);
+  fprintf(file, "GjkDegenerateSimplices %zu\n", mDegenerateSimplices);
+  fprintf(file, "GjkSeparatingAxisExits %zu\n", mSeparatingAxisExits);
+  for (size_t i = 0; i < cIterationBuckets; ++i)
+  {
+    fprintf(file, "GjkIterationHistogram %s %zu\n", cIterationBucketNames[i], mIterationHistogram[i]);
+  }
+}
+
+const char* GjkStatistics::cIterationBucketNames[cIterationBuckets] = { "1", "2", "3", "4", "5-8", "9-16", "17-32", "33+" };
+
+//-----------------------------------------------------------------------------SupportTransform
+SupportTransform::SupportTransform()
+{
+  mBuiltFrom = None;
+}
+
+void SupportTransform::Update(const Vector3& scale, const Matrix3& rotation, const Vector3& translation)
+{
+  if (mBuiltFrom == FromMatrix && mScale == scale && mRotation == rotation && mTranslation == translation)
+  {
+    return;
+  }
+  Build(scale, rotation, translation);
+  mBuiltFrom = FromMatrix;
+}
+
+void SupportTransform::Update(const Vector3& scale, const Quaternion& rotation, const Vector3& translation)
+{
+  if (mBuiltFrom == FromQuaternion && mScale == scale && mQuaternion == rotation && mTranslation == translation)
+  {
+    return;
+  }
+  Build(scale, Math::ToMatrix3(rotation), translation);
+  mQuaternion = rotation;
+  mBuiltFrom = FromQuaternion;
+}
+
+Vector3 SupportTransform::ToLocalDirection(const Vector3& worldDirection) const
+{
+  return Math::TransposedTransform(mLinear, worldDirection);
+}
+
+Vector3 SupportTransform::ToWorldPoint(const Vector3& localPoint) const
+{
+  return Math::TransformPoint(mLocalToWorld, localPoint);
+}
+
+Vector3 SupportTransform::ToRelativePoint(const Vector3& localPoint, const Vector3& origin) const
+{
+  return (mTranslation - origin) + Math::Transform(mLinear, localPoint);
+}
+
+void SupportTransform::Build(const Vector3& scale, const Matrix3& rotation, const Vector3& translation)
+{
+  mScale = scale;
+  mRotation = rotation;
+  mTranslation = translation;
+  mLocalToWorld = Math::BuildTransform(translation, rotation, scale);
+  mLinear = Math::ToMatrix3(mLocalToWorld);
+}
 
 //-----------------------------------------------------------------------------SupportShape
 Vector3 SupportShape::GetCenter(const std::vector<Vector3>& localPoints, const Matrix4& transform) const
@@ -29,20 +140,86 @@ Vector3 SupportShape::GetCenter(const std::vector<Vector3>& localPoints, const M
 
 Vector3 SupportShape::Support(const Vector3& worldDirection, const std::vector<Vector3>& localPoints, const Matrix4& localToWorldTransform) const
 {
-  Vector3 result = Vector3::cZero;
+  // Dot(M * p, d) == Dot(p, transpose(M) * d) so only the winning point needs transforming
+  Vector3 localDirection = Math::TransformNormal(localToWorldTransform.Transposed(), worldDirection);
   const size_t size = localPoints.size();
+  size_t maxIndex = 0;
   float maxDot = -std::numeric_limits<float>::max();
 
   for (size_t i = 0; i < size; ++i)
   {
-    float dot = Math::Dot(Math::TransformPoint(localToWorldTransform, localPoints[i]), worldDirection);
+    float dot = Math::Dot(localPoints[i], localDirection);
     if (maxDot < dot)
     {
       maxDot = dot;
-      result = Math::TransformPoint(localToWorldTransform, localPoints[i]);
+      maxIndex = i;
     }
   }
-  return result;
+  if (size == 0)
+  {
+    return Vector3::cZero;
+  }
+  return Math::TransformPoint(localToWorldTransform, localPoints[maxIndex]);
+}
+
+Vector3 SupportShape::Support(const Vector3& worldDirection, const std::vector<Vector3>& localPoints, const SupportTransform& transform) const
+{
+  size_t maxIndex = MaxDotIndex(localPoints, transform.ToLocalDirection(worldDirection));
+  if (maxIndex == localPoints.size())
+  {
+    return Vector3::cZero;
+  }
+  return transform.ToWorldPoint(localPoints[maxIndex]);
+}
+
+size_t SupportShape::MaxDotIndex(const std::vector<Vector3>& localPoints, const Vector3& localDirection)
+{
+  const size_t size = localPoints.size();
+  if (size == 0)
+  {
+    return 0;
+  }
+
+  size_t maxIndex = 0;
+  float maxDot = -std::numeric_limits<float>::max();
+  for (size_t i = 0; i < size; ++i)
+  {
+    float dot = Math::Dot(localPoints[i], localDirection);
+    if (maxDot < dot)
+    {
+      maxDot = dot;
+      maxIndex = i;
+    }
+  }
+  return maxIndex;
+}
+
+Vector3 SupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  return Support(worldDirection) - origin;
+}
+
+void SupportShape::SupportBatch(const Vector3* worldDirections, size_t count, Vector3* results) const
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    results[i] = Support(worldDirections[i]);
+  }
+}
+
+Aabb SupportShape::GetAabb() const
+{
+  const Vector3 directions[6] = { Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1), Vector3(-1, 0, 0), Vector3(0, -1, 0), Vector3(0, 0, -1) };
+  Vector3 supports[6];
+  SupportBatch(directions, 6, supports);
+
+  Aabb aabb;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    aabb.mMax[i] = supports[i][i];
+    aabb.mMin[i] = supports[i + 3][i];
+  }
+  return aabb;
 }
 
 void SupportShape::DebugDraw(const std::vector<Vector3>& localPoints, const Matrix4& localToWorldTransform, const Vector4& color) const
@@ -55,20 +232,99 @@ void SupportShape::DebugDraw(const std::vector<Vector3>& localPoints, const Matr
   }
 }
 
+void SupportShape::DebugDrawSupports(const Vector4& color) const
+{
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      for (int z = -1; z <= 1; ++z)
+      {
+        if (x == 0 && y == 0 && z == 0)
+        {
+          continue;
+        }
+        Vector3 direction(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+        DebugShape& point = gDebugDrawer->DrawPoint(Support(direction));
+        point.Color(color);
+      }
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------ModelSupportShape
+ModelSupportShape::ModelSupportShape()
+{
+  mModel = nullptr;
+  mLastSupportVertex = 0;
+  mTransformGathered = false;
+}
+
 Vector3 ModelSupportShape::GetCenter() const
 {
-  return SupportShape::GetCenter(mModel->mMesh->mVertices, mModel->mOwner->has(Transform)->GetTransform());
+  return SupportShape::GetCenter(mModel->mMesh->mVertices, GetTransform().mLocalToWorld);
 }
 
 Vector3 ModelSupportShape::Support(const Vector3& worldDirection) const
 {
-  return SupportShape::Support(worldDirection, mModel->mMesh->mVertices, mModel->mOwner->has(Transform)->GetTransform());
+  const std::vector<Vector3>& vertices = mModel->mMesh->mVertices;
+  const SupportTransform& transform = GetTransform();
+  size_t vertex = SupportVertex(transform.ToLocalDirection(worldDirection));
+  if (vertex == vertices.size())
+  {
+    return Vector3::cZero;
+  }
+  return transform.ToWorldPoint(vertices[vertex]);
+}
+
+Vector3 ModelSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  const std::vector<Vector3>& vertices = mModel->mMesh->mVertices;
+  const SupportTransform& transform = GetTransform();
+  size_t vertex = SupportVertex(transform.ToLocalDirection(worldDirection));
+  if (vertex == vertices.size())
+  {
+    return -origin;
+  }
+  return transform.ToRelativePoint(vertices[vertex], origin);
 }
 
 void ModelSupportShape::DebugDraw(const Vector4& color) const
 {
-  SupportShape::DebugDraw(mModel->mMesh->mVertices, mModel->mOwner->has(Transform)->GetTransform());
+  SupportShape::DebugDraw(mModel->mMesh->mVertices, GetTransform().mLocalToWorld);
+}
+
+void ModelSupportShape::GatherTransform()
+{
+  mTransformGathered = false;
+  GetTransform();
+  mTransformGathered = true;
+}
+
+size_t ModelSupportShape::SupportVertex(const Vector3& localDirection) const
+{
+  const Mesh* mesh = mModel->mMesh;
+  if (mesh->HasAdjacency())
+  {
+    mLastSupportVertex = mesh->HillClimb(localDirection, mLastSupportVertex);
+    return mLastSupportVertex;
+  }
+  if (mesh->HasSoaVertices())
+  {
+    return mesh->MaxDotVertex(localDirection);
+  }
+  return MaxDotIndex(mesh->mVertices, localDirection);
+}
+
+const SupportTransform& ModelSupportShape::GetTransform() const
+{
+  if (mTransformGathered)
+  {
+    return mTransform;
+  }
+  const Transform* transform = mModel->mOwner->has(Transform);
+  mTransform.Update(transform->mScale, transform->mRotation, transform->mTranslation);
+  return mTransform;
 }
 
 //-----------------------------------------------------------------------------PointsSupportShape
@@ -81,20 +337,34 @@ PointsSupportShape::PointsSupportShape()
 
 Vector3 PointsSupportShape::GetCenter() const
 {
-  Matrix4 transform = Math::BuildTransform(mTranslation, mRotation, mScale);
-  return SupportShape::GetCenter(mLocalSpacePoints, transform);
+  return SupportShape::GetCenter(mLocalSpacePoints, GetTransform().mLocalToWorld);
 }
 
 Vector3 PointsSupportShape::Support(const Vector3& worldDirection) const
 {
-  Matrix4 transform = Math::BuildTransform(mTranslation, mRotation, mScale);
-  return SupportShape::Support(worldDirection, mLocalSpacePoints, transform);
+  return SupportShape::Support(worldDirection, mLocalSpacePoints, GetTransform());
+}
+
+Vector3 PointsSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  const SupportTransform& transform = GetTransform();
+  size_t maxIndex = MaxDotIndex(mLocalSpacePoints, transform.ToLocalDirection(worldDirection));
+  if (maxIndex == mLocalSpacePoints.size())
+  {
+    return -origin;
+  }
+  return transform.ToRelativePoint(mLocalSpacePoints[maxIndex], origin);
 }
 
 void PointsSupportShape::DebugDraw(const Vector4& color) const
 {
-  Matrix4 transform = Math::BuildTransform(mTranslation, mRotation, mScale);
-  SupportShape::DebugDraw(mLocalSpacePoints, transform, color);
+  SupportShape::DebugDraw(mLocalSpacePoints, GetTransform().mLocalToWorld, color);
+}
+
+const SupportTransform& PointsSupportShape::GetTransform() const
+{
+  mTransform.Update(mScale, mRotation, mTranslation);
+  return mTransform;
 }
 
 //-----------------------------------------------------------------------------SphereSupportShape
@@ -108,6 +378,11 @@ Vector3 SphereSupportShape::Support(const Vector3& worldDirection) const
   return mSphere.mCenter + (worldDirection.Normalized() * mSphere.mRadius);
 }
 
+Vector3 SphereSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  return (mSphere.mCenter - origin) + (worldDirection.Normalized() * mSphere.mRadius);
+}
+
 void SphereSupportShape::DebugDraw(const Vector4& color) const
 {
   DebugShape& shape = gDebugDrawer->DrawSphere(mSphere);
@@ -115,6 +390,14 @@ void SphereSupportShape::DebugDraw(const Vector4& color) const
 }
 
 //-----------------------------------------------------------------------------ObbSupportShape
+ObbSupportShape::ObbSupportShape()
+{
+  mScale = Vector3(1);
+  mRotation = Matrix3::cIdentity;
+  mTranslation = Vector3::cZero;
+  mHalfAxesBuilt = false;
+}
+
 Vector3 ObbSupportShape::GetCenter() const
 {
   return mTranslation;
@@ -122,15 +405,59 @@ Vector3 ObbSupportShape::GetCenter() const
 
 Vector3 ObbSupportShape::Support(const Vector3& worldDirection) const
 {
+  // The rotation is orthonormal so its transpose takes the direction into local space
+  const Vector3* halfAxes = GetHalfAxes();
+  Vector3 localDirection = Math::TransposedTransform(mRotation, worldDirection);
   Vector3 result = GetCenter();
-  Vector3 localDirection = Math::Transform(mRotation.Inverted(), worldDirection);
   for (int i = 0; i < 3; ++i)
   {
-    result += Math::GetSign(localDirection[i]) * mScale[i] * 0.5f * mRotation.Basis(i);
+    result += Math::GetSign(localDirection[i]) * halfAxes[i];
+  }
+  return result;
+}
+
+void ObbSupportShape::SupportBatch(const Vector3* worldDirections, size_t count, Vector3* results) const
+{
+  const Vector3* halfAxes = GetHalfAxes();
+  for (size_t j = 0; j < count; ++j)
+  {
+    Vector3 localDirection = Math::TransposedTransform(mRotation, worldDirections[j]);
+    Vector3 result = mTranslation;
+    for (int i = 0; i < 3; ++i)
+    {
+      result += Math::GetSign(localDirection[i]) * halfAxes[i];
+    }
+    results[j] = result;
+  }
+}
+
+Vector3 ObbSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  const Vector3* halfAxes = GetHalfAxes();
+  Vector3 localDirection = Math::TransposedTransform(mRotation, worldDirection);
+  Vector3 result = mTranslation - origin;
+  for (int i = 0; i < 3; ++i)
+  {
+    result += Math::GetSign(localDirection[i]) * halfAxes[i];
   }
   return result;
 }
 
+const Vector3* ObbSupportShape::GetHalfAxes() const
+{
+  if (!mHalfAxesBuilt || mBuiltScale != mScale || mBuiltRotation != mRotation)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      mHalfAxes[i] = mScale[i] * 0.5f * mRotation.Basis(i);
+    }
+    mBuiltScale = mScale;
+    mBuiltRotation = mRotation;
+    mHalfAxesBuilt = true;
+  }
+  return mHalfAxes;
+}
+
 void ObbSupportShape::DebugDraw(const Vector4& color) const
 {
   Matrix4 transform = Math::BuildTransform(mTranslation, mRotation, mScale);
@@ -139,98 +466,394 @@ void ObbSupportShape::DebugDraw(const Vector4& color) const
   shape.SetTransform(transform);
 }
 
-
-//------------------------------------------------------------ Voronoi Region Tests
-VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0,
-  size_t& newSize, int newIndices[4],
-  Vector3& closestPoint, Vector3& searchDirection)
+//-----------------------------------------------------------------------------Round shapes
+// The part of the direction perpendicular to the axis scaled to the given radius (zero if the direction is along the axis).
+static Vector3 RadialSupport(const Vector3& worldDirection, const Vector3& axis, float radius)
 {
-  newSize = 1;
-  closestPoint = p0;
-  searchDirection = q - p0;
-  return VoronoiRegion::Point0;
+  Vector3 radial = worldDirection - Math::Dot(worldDirection, axis) * axis;
+  float length = radial.Length();
+  if (length <= cDegenerateEpsilon)
+  {
+    return Vector3::cZero;
+  }
+  return radial * (radius / length);
 }
 
-VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0, const Vector3& p1,
-  size_t& newSize, int newIndices[4],
-  Vector3& closestPoint, Vector3& searchDirection)
+// Draws a circle around the local y axis of the rotation.
+static void DrawRing(const Vector3& center, const Matrix3& rotation, float radius, const Vector4& color)
 {
-  BarycentricCoordinates(q, p0, p1, u, v);
-  if (v <= 0.0f)
+  const size_t segments = 16;
+  Vector3 previous = center + radius * rotation.Basis(0);
+  for (size_t i = 1; i <= segments; ++i)
   {
-    newSize = 1;
-    newIndices[0] = 0;
-    closestPoint = p0;
-    searchDirection = q - p0;
-
-    return VoronoiRegion::Point0;
+    float angle = Math::cTwoPi * static_cast<float>(i) / static_cast<float>(segments);
+    Vector3 point = center + radius * (Math::Cos(angle) * rotation.Basis(0) + Math::Sin(angle) * rotation.Basis(2));
+    gDebugDrawer->DrawLine(LineSegment(previous, point)).Color(color);
+    previous = point;
   }
-  if (u <= 0.0f)
-  {
-    newSize = 1;
-    newIndices[0] = 1;
-    closestPoint = p1;
-    searchDirection = q - p1;
+}
 
-    return VoronoiRegion::Point1;
-  }
+//-----------------------------------------------------------------------------CapsuleSupportShape
+CapsuleSupportShape::CapsuleSupportShape()
+{
+  mTranslation = Vector3::cZero;
+  mRotation = Matrix3::cIdentity;
+  mHalfHeight = 0.5f;
+  mRadius = 0.5f;
+}
 
-  newSize = 2;
-  newIndices[0] = 0;
-  newIndices[1] = 1;
-  closestPoint = (p0 * u) + (p1 * v);
-  searchDirection = q - closestPoint;
+Vector3 CapsuleSupportShape::GetCenter() const
+{
+  return mTranslation;
+}
 
-  return VoronoiRegion::Edge01;
+Vector3 CapsuleSupportShape::Support(const Vector3& worldDirection) const
+{
+  Vector3 axis = mRotation.Basis(1);
+  float side = Math::Dot(worldDirection, axis) >= 0.0f ? 1.0f : -1.0f;
+  Vector3 result = mTranslation + side * mHalfHeight * axis;
+  float length = worldDirection.Length();
+  if (length > cDegenerateEpsilon)
+  {
+    result += worldDirection * (mRadius / length);
+  }
+  return result;
 }
 
-VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0, const Vector3& p1, const Vector3& p2,
-  size_t& newSize, int newIndices[4],
-  Vector3& closestPoint, Vector3& searchDirection)
+Vector3 CapsuleSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
 {
-  float u01, v01, u12, v12, u02, v02;
-  BarycentricCoordinates(q, p0, p1, u01, v01);
-  BarycentricCoordinates(q, p0, p2, u02, v02);
-  BarycentricCoordinates(q, p1, p2, u12, v12);
+  // Same as Support with the translation swapped for the relative one
+  CapsuleSupportShape relative = *this;
+  relative.mTranslation = mTranslation - origin;
+  return relative.Support(worldDirection);
+}
 
-  if (v01 <= 0.0f && v02 <= 0.0f)
+void CapsuleSupportShape::DebugDraw(const Vector4& color) const
+{
+  Vector3 axis = mRotation.Basis(1);
+  Vector3 top = mTranslation + mHalfHeight * axis;
+  Vector3 bottom = mTranslation - mHalfHeight * axis;
+  gDebugDrawer->DrawSphere(Sphere(top, mRadius)).Color(color);
+  gDebugDrawer->DrawSphere(Sphere(bottom, mRadius)).Color(color);
+  for (size_t i = 0; i < 3; i += 2)
   {
-    newSize = 1;
-    newIndices[0] = 0;
-    closestPoint = p0;
-    searchDirection = q - p0;
-
-    return VoronoiRegion::Point0;
+    Vector3 offset = mRadius * mRotation.Basis(i);
+    gDebugDrawer->DrawLine(LineSegment(top + offset, bottom + offset)).Color(color);
+    gDebugDrawer->DrawLine(LineSegment(top - offset, bottom - offset)).Color(color);
   }
-  if (u01 <= 0.0f && v12 <= 0.0f)
-  {
-    newSize = 1;
-    newIndices[0] = 1;
-    closestPoint = p1;
-    searchDirection = q - p1;
+}
 
-    return VoronoiRegion::Point1;
-  }
-  if (u02 <= 0.0f && u12 <= 0.0f)
-  {
-    newSize = 1;
-    newIndices[0] = 2;
-    closestPoint = p2;
-    searchDirection = q - p2;
+//-----------------------------------------------------------------------------CylinderSupportShape
+CylinderSupportShape::CylinderSupportShape()
+{
+  mTranslation = Vector3::cZero;
+  mRotation = Matrix3::cIdentity;
+  mHalfHeight = 0.5f;
+  mRadius = 0.5f;
+}
 
-    return VoronoiRegion::Point2;
-  }
+Vector3 CylinderSupportShape::GetCenter() const
+{
+  return mTranslation;
+}
 
-  BarycentricCoordinates(q, p0, p1, p2, u, v, w);
-  if (u01 > 0.0f && v01 > 0.0f && w <= 0.0f)
-  {
-    newSize = 2;
-    newIndices[0] = 0;
-    newIndices[1] = 1;
-    closestPoint = (p0 * u01) + (p1 * v01);
-    searchDirection = q - closestPoint;
+Vector3 CylinderSupportShape::Support(const Vector3& worldDirection) const
+{
+  Vector3 axis = mRotation.Basis(1);
+  float side = Math::Dot(worldDirection, axis) >= 0.0f ? 1.0f : -1.0f;
+  return mTranslation + side * mHalfHeight * axis + RadialSupport(worldDirection, axis, mRadius);
+}
 
-    return VoronoiRegion::Edge01;
+Vector3 CylinderSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  CylinderSupportShape relative = *this;
+  relative.mTranslation = mTranslation - origin;
+  return relative.Support(worldDirection);
+}
+
+void CylinderSupportShape::DebugDraw(const Vector4& color) const
+{
+  Vector3 axis = mRotation.Basis(1);
+  Vector3 top = mTranslation + mHalfHeight * axis;
+  Vector3 bottom = mTranslation - mHalfHeight * axis;
+  DrawRing(top, mRotation, mRadius, color);
+  DrawRing(bottom, mRotation, mRadius, color);
+  for (size_t i = 0; i < 3; i += 2)
+  {
+    Vector3 offset = mRadius * mRotation.Basis(i);
+    gDebugDrawer->DrawLine(LineSegment(top + offset, bottom + offset)).Color(color);
+    gDebugDrawer->DrawLine(LineSegment(top - offset, bottom - offset)).Color(color);
+  }
+}
+
+//-----------------------------------------------------------------------------ConeSupportShape
+ConeSupportShape::ConeSupportShape()
+{
+  mTranslation = Vector3::cZero;
+  mRotation = Matrix3::cIdentity;
+  mHalfHeight = 0.5f;
+  mRadius = 0.5f;
+}
+
+Vector3 ConeSupportShape::GetCenter() const
+{
+  return mTranslation;
+}
+
+Vector3 ConeSupportShape::Support(const Vector3& worldDirection) const
+{
+  // The apex wins whenever the direction is closer to the axis than the cone's slant is
+  Vector3 axis = mRotation.Basis(1);
+  float sinAngle = mRadius / Math::Sqrt(mRadius * mRadius + 4.0f * mHalfHeight * mHalfHeight);
+  if (Math::Dot(worldDirection, axis) > worldDirection.Length() * sinAngle)
+  {
+    return mTranslation + mHalfHeight * axis;
+  }
+  return mTranslation - mHalfHeight * axis + RadialSupport(worldDirection, axis, mRadius);
+}
+
+Vector3 ConeSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  ConeSupportShape relative = *this;
+  relative.mTranslation = mTranslation - origin;
+  return relative.Support(worldDirection);
+}
+
+void ConeSupportShape::DebugDraw(const Vector4& color) const
+{
+  Vector3 axis = mRotation.Basis(1);
+  Vector3 apex = mTranslation + mHalfHeight * axis;
+  Vector3 base = mTranslation - mHalfHeight * axis;
+  DrawRing(base, mRotation, mRadius, color);
+  for (size_t i = 0; i < 3; i += 2)
+  {
+    Vector3 offset = mRadius * mRotation.Basis(i);
+    gDebugDrawer->DrawLine(LineSegment(apex, base + offset)).Color(color);
+    gDebugDrawer->DrawLine(LineSegment(apex, base - offset)).Color(color);
+  }
+}
+
+//-----------------------------------------------------------------------------MinkowskiSumSupportShape
+MinkowskiSumSupportShape::MinkowskiSumSupportShape()
+{
+  mShapeA = nullptr;
+  mShapeB = nullptr;
+}
+
+Vector3 MinkowskiSumSupportShape::GetCenter() const
+{
+  return mShapeA->GetCenter() + mShapeB->GetCenter();
+}
+
+Vector3 MinkowskiSumSupportShape::Support(const Vector3& worldDirection) const
+{
+  return mShapeA->Support(worldDirection) + mShapeB->Support(worldDirection);
+}
+
+Vector3 MinkowskiSumSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  // Only one side takes the origin, the other is usually a small shape around the world origin (a sweep or a margin)
+  return mShapeA->RelativeSupport(worldDirection, origin) + mShapeB->Support(worldDirection);
+}
+
+void MinkowskiSumSupportShape::DebugDraw(const Vector4& color) const
+{
+  DebugDrawSupports(color);
+}
+
+//-----------------------------------------------------------------------------ConvexHullSupportShape
+ConvexHullSupportShape::ConvexHullSupportShape()
+{
+  mShapeA = nullptr;
+  mShapeB = nullptr;
+}
+
+Vector3 ConvexHullSupportShape::GetCenter() const
+{
+  return (mShapeA->GetCenter() + mShapeB->GetCenter()) * 0.5f;
+}
+
+Vector3 ConvexHullSupportShape::Support(const Vector3& worldDirection) const
+{
+  Vector3 pointA = mShapeA->Support(worldDirection);
+  Vector3 pointB = mShapeB->Support(worldDirection);
+  if (Math::Dot(pointA, worldDirection) >= Math::Dot(pointB, worldDirection))
+  {
+    return pointA;
+  }
+  return pointB;
+}
+
+Vector3 ConvexHullSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  // Both points moved by the same origin so comparing them still picks the furthest
+  Vector3 pointA = mShapeA->RelativeSupport(worldDirection, origin);
+  Vector3 pointB = mShapeB->RelativeSupport(worldDirection, origin);
+  if (Math::Dot(pointA, worldDirection) >= Math::Dot(pointB, worldDirection))
+  {
+    return pointA;
+  }
+  return pointB;
+}
+
+void ConvexHullSupportShape::DebugDraw(const Vector4& color) const
+{
+  mShapeA->DebugDraw(color);
+  mShapeB->DebugDraw(color);
+}
+
+//-----------------------------------------------------------------------------TransformedSupportShape
+TransformedSupportShape::TransformedSupportShape()
+{
+  mShape = nullptr;
+  mScale = Vector3(1);
+  mRotation = Matrix3::cIdentity;
+  mTranslation = Vector3::cZero;
+}
+
+Vector3 TransformedSupportShape::GetCenter() const
+{
+  return GetTransform().ToWorldPoint(mShape->GetCenter());
+}
+
+Vector3 TransformedSupportShape::Support(const Vector3& worldDirection) const
+{
+  const SupportTransform& transform = GetTransform();
+  return transform.ToWorldPoint(mShape->Support(transform.ToLocalDirection(worldDirection)));
+}
+
+Vector3 TransformedSupportShape::RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const
+{
+  const SupportTransform& transform = GetTransform();
+  return transform.ToRelativePoint(mShape->Support(transform.ToLocalDirection(worldDirection)), origin);
+}
+
+void TransformedSupportShape::DebugDraw(const Vector4& color) const
+{
+  DebugDrawSupports(color);
+}
+
+const SupportTransform& TransformedSupportShape::GetTransform() const
+{
+  mTransform.Update(mScale, mRotation, mTranslation);
+  return mTransform;
+}
+
+//-----------------------------------------------------------------------------RelativeOriginSupportShape
+RelativeOriginSupportShape::RelativeOriginSupportShape()
+{
+  mShape = nullptr;
+  mOrigin = Vector3::cZero;
+}
+
+Vector3 RelativeOriginSupportShape::GetCenter() const
+{
+  return mShape->GetCenter() - mOrigin;
+}
+
+Vector3 RelativeOriginSupportShape::Support(const Vector3& worldDirection) const
+{
+  return mShape->RelativeSupport(worldDirection, mOrigin);
+}
+
+void RelativeOriginSupportShape::DebugDraw(const Vector4& color) const
+{
+  mShape->DebugDraw(color);
+}
+
+//------------------------------------------------------------ Voronoi Region Tests
+VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0,
+  size_t& newSize, int newIndices[4],
+  Vector3& closestPoint, Vector3& searchDirection)
+{
+  newSize = 1;
+  closestPoint = p0;
+  searchDirection = q - p0;
+  return VoronoiRegion::Point0;
+}
+
+VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0, const Vector3& p1,
+  size_t& newSize, int newIndices[4],
+  Vector3& closestPoint, Vector3& searchDirection)
+{
+  float u = 0.0f, v = 0.0f;
+  BarycentricCoordinates(q, p0, p1, u, v);
+  if (v <= 0.0f)
+  {
+    newSize = 1;
+    newIndices[0] = 0;
+    closestPoint = p0;
+    searchDirection = q - p0;
+
+    return VoronoiRegion::Point0;
+  }
+  if (u <= 0.0f)
+  {
+    newSize = 1;
+    newIndices[0] = 1;
+    closestPoint = p1;
+    searchDirection = q - p1;
+
+    return VoronoiRegion::Point1;
+  }
+
+  newSize = 2;
+  newIndices[0] = 0;
+  newIndices[1] = 1;
+  closestPoint = (p0 * u) + (p1 * v);
+  searchDirection = q - closestPoint;
+
+  return VoronoiRegion::Edge01;
+}
+
+VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3& p0, const Vector3& p1, const Vector3& p2,
+  size_t& newSize, int newIndices[4],
+  Vector3& closestPoint, Vector3& searchDirection)
+{
+  float u01, v01, u12, v12, u02, v02;
+  BarycentricCoordinates(q, p0, p1, u01, v01);
+  BarycentricCoordinates(q, p0, p2, u02, v02);
+  BarycentricCoordinates(q, p1, p2, u12, v12);
+
+  if (v01 <= 0.0f && v02 <= 0.0f)
+  {
+    newSize = 1;
+    newIndices[0] = 0;
+    closestPoint = p0;
+    searchDirection = q - p0;
+
+    return VoronoiRegion::Point0;
+  }
+  if (u01 <= 0.0f && v12 <= 0.0f)
+  {
+    newSize = 1;
+    newIndices[0] = 1;
+    closestPoint = p1;
+    searchDirection = q - p1;
+
+    return VoronoiRegion::Point1;
+  }
+  if (u02 <= 0.0f && u12 <= 0.0f)
+  {
+    newSize = 1;
+    newIndices[0] = 2;
+    closestPoint = p2;
+    searchDirection = q - p2;
+
+    return VoronoiRegion::Point2;
+  }
+
+  float u = 0.0f, v = 0.0f, w = 0.0f;
+  BarycentricCoordinates(q, p0, p1, p2, u, v, w);
+  if (u01 > 0.0f && v01 > 0.0f && w <= 0.0f)
+  {
+    newSize = 2;
+    newIndices[0] = 0;
+    newIndices[1] = 1;
+    closestPoint = (p0 * u01) + (p1 * v01);
+    searchDirection = q - closestPoint;
+
+    return VoronoiRegion::Edge01;
   }
   if (u02 > 0.0f && v02 > 0.0f && v <= 0.0f)
   {
@@ -383,10 +1006,10 @@ VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3&
     return VoronoiRegion::Edge23;
   }
 
-  u = DistanceToPlane(q, p1, p2, p3) / DistanceToPlane(p0, p1, p2, p3);
-  v = DistanceToPlane(q, p0, p2, p3) / DistanceToPlane(p1, p0, p2, p3);
-  w = DistanceToPlane(q, p0, p1, p3) / DistanceToPlane(p2, p0, p1, p3);
-  t = 1.0f - u - w - v;
+  float u = DistanceToPlane(q, p1, p2, p3) / DistanceToPlane(p0, p1, p2, p3);
+  float v = DistanceToPlane(q, p0, p2, p3) / DistanceToPlane(p1, p0, p2, p3);
+  float w = DistanceToPlane(q, p0, p1, p3) / DistanceToPlane(p2, p0, p1, p3);
+  float t = 1.0f - u - w - v;
 
   if (u012 > 0.0f && v012 > 0.0f && w012 > 0.0f && t <= 0.0f)
   {
@@ -444,157 +1067,1409 @@ VoronoiRegion::Type Gjk::IdentifyVoronoiRegion(const Vector3& q, const Vector3&
   return VoronoiRegion::Tetrahedra0123;
 }
 
+//-----------------------------------------------------------------------------Shape dispatch
+// Qualified calls skip the vtable so the concrete shapes' functions can be inlined into the templated queries.
+// SupportShape itself has no implementation to call directly so it keeps the virtual call.
+template <typename Shape>
+inline Vector3 ShapeSupport(const Shape* shape, const Vector3& direction)
+{
+  return shape->Shape::Support(direction);
+}
+
+template <>
+inline Vector3 ShapeSupport<SupportShape>(const SupportShape* shape, const Vector3& direction)
+{
+  return shape->Support(direction);
+}
+
+template <typename Shape>
+inline Vector3 ShapeCenter(const Shape* shape)
+{
+  return shape->Shape::GetCenter();
+}
+
+template <>
+inline Vector3 ShapeCenter<SupportShape>(const SupportShape* shape)
+{
+  return shape->GetCenter();
+}
+
+template <typename ShapeA, typename ShapeB>
+inline Gjk::CsoPoint CsoSupport(const ShapeA* shapeA, const ShapeB* shapeB, const Vector3& direction)
+{
+  Gjk::CsoPoint result;
+  result.mPointA = ShapeSupport(shapeA, direction);
+  result.mPointB = ShapeSupport(shapeB, -direction);
+  result.mCsoPoint = result.mPointA - result.mPointB;
+  return result;
+}
+
+//-----------------------------------------------------------------------------Gjk
+Gjk::SimplexCache::SimplexCache()
+{
+  mSize = 0;
+  mSeparatingAxis = Vector3::cZero;
+  mHasSeparatingAxis = false;
+}
+
 Gjk::Gjk()
 {
+  mSimplexSize = 0;
 }
 
-bool Gjk::Intersect(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon, int debuggingIndex, bool debugDraw)
+void Gjk::RecordQuery(size_t iterations, bool epsilonExit, bool maxIterationExit)
 {
-  Vector3 searchDirection = shapeA->GetCenter() - shapeB->GetCenter();
+  ++mStatistics.mCalls;
+  mStatistics.mIterations += iterations;
+  mStatistics.mMaxIterations = Math::Max(mStatistics.mMaxIterations, iterations);
+  if (epsilonExit)
+  {
+    ++mStatistics.mEpsilonExits;
+  }
+  if (maxIterationExit)
+  {
+    ++mStatistics.mMaxIterationExits;
+  }
 
-  if (searchDirection == Vector3::cZero)
+  size_t bucket = 0;
+  size_t bucketEnd = 1;
+  while (bucket + 1 < GjkStatistics::cIterationBuckets && iterations > bucketEnd)
   {
-    searchDirection = -Vector3::cXAxis;
+    ++bucket;
+    bucketEnd = bucket < 4 ? bucket + 1 : bucketEnd * 2;
   }
-  searchDirection.Normalize();
-  CsoPoint simplex[4];
-  simplex[0] = ComputeSupport(shapeA, shapeB, searchDirection);
-  searchDirection = -simplex[0].mCsoPoint;
+  ++mStatistics.mIterationHistogram[bucket];
+}
 
+template <typename ShapeA, typename ShapeB>
+bool Gjk::Intersect(const ShapeA* shapeA, const ShapeB* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon,
+  SimplexCache* cache)
+{
+  CsoPoint simplex[4];
+  Vector3 directions[4];
+  Vector3 searchDirection;
   size_t newSize = 1;
-  int newIndices[4]{ 0,0,0,0 };
-  VoronoiRegion::Type vr;
-  Vector3 P = Vector3::cZero;
 
-  for (size_t i = 0; i < maxIterations; ++i)
+  if (cache != nullptr && cache->mSize != 0)
   {
-    Vector3 Q = Vector3::cZero;
-
-    switch (newSize)
-    {
-    case 1:
-      vr = IdentifyVoronoiRegion(Q, simplex[0].mCsoPoint, newSize, newIndices, P, searchDirection);
-      break;
-    case 2:
-      vr = IdentifyVoronoiRegion(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, newSize, newIndices, P, searchDirection);
-      break;
-    case 3:
-      vr = IdentifyVoronoiRegion(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[2].mCsoPoint, newSize, newIndices, P, searchDirection);
-      break;
-    case 4:
-      vr = IdentifyVoronoiRegion(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint, newSize, newIndices, P, searchDirection);
-      break;
-    }
+    newSize = WarmStart(shapeA, shapeB, *cache, simplex, directions);
+  }
+  else
+  {
+    searchDirection = ShapeCenter(shapeA) - ShapeCenter(shapeB);
 
-    if (P == Vector3::cZero)
+    if (searchDirection == Vector3::cZero)
     {
-      return true;
+      searchDirection = -Vector3::cXAxis;
     }
+    searchDirection.Normalize();
+    simplex[0] = CsoSupport(shapeA, shapeB, searchDirection);
+    directions[0] = searchDirection;
+    mStatistics.mSupportCalls += 2;
+  }
+  searchDirection = -simplex[0].mCsoPoint;
 
-    switch (vr)
+  // Kept outside the loop so running out of iterations can still report the closest point found so far
+  CsoPoint closest = simplex[0];
+  for (size_t i = 0; i < maxIterations; ++i)
+  {
+    if (ReduceSimplex(simplex, directions, newSize, closest, searchDirection))
     {
-    case VoronoiRegion::Point0:
-    case VoronoiRegion::Point1:
-    case VoronoiRegion::Point2:
-    case VoronoiRegion::Point3:
-      u = 0.0f;
-      v = 0.0f;
-      w = 0.0f;
-      t = 0.0f;
-      break;
-    case VoronoiRegion::Edge01:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, u, v);
-      break;
-    case VoronoiRegion::Edge02:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[2].mCsoPoint, u, v);
-      break;
-    case VoronoiRegion::Edge03:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[3].mCsoPoint, u, v);
-      break;
-    case VoronoiRegion::Edge12:
-      BarycentricCoordinates(Q, simplex[1].mCsoPoint, simplex[2].mCsoPoint, u, v);
-      break;
-    case VoronoiRegion::Edge13:
-      BarycentricCoordinates(Q, simplex[1].mCsoPoint, simplex[3].mCsoPoint, u, v);
-      break;
-    case VoronoiRegion::Edge23:
-      BarycentricCoordinates(Q, simplex[2].mCsoPoint, simplex[3].mCsoPoint, u, v);
-      break;
-
-    case VoronoiRegion::Triangle012:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[2].mCsoPoint, u, v, w);
-      break;
-    case VoronoiRegion::Triangle013:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[3].mCsoPoint, u, v, w);
-      break;
-    case VoronoiRegion::Triangle023:
-      BarycentricCoordinates(Q, simplex[0].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint, u, v, w);
-      break;
-    case VoronoiRegion::Triangle123:
-      BarycentricCoordinates(Q, simplex[1].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint, u, v, w);
-      break;
-
-    case VoronoiRegion::Tetrahedra0123:
-      u = DistanceToPlane(Q, simplex[1].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint) / DistanceToPlane(simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint);
-      v = DistanceToPlane(Q, simplex[0].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint) / DistanceToPlane(simplex[1].mCsoPoint, simplex[0].mCsoPoint, simplex[2].mCsoPoint, simplex[3].mCsoPoint);
-      w = DistanceToPlane(Q, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[3].mCsoPoint) / DistanceToPlane(simplex[2].mCsoPoint, simplex[0].mCsoPoint, simplex[1].mCsoPoint, simplex[3].mCsoPoint);
-      t = 1.0f - u - v - w;
-      break;
+      ++mStatistics.mDegenerateSimplices;
     }
+    Vector3 P = closest.mCsoPoint;
 
-    for (size_t j = 0; j < newSize; j++)
+    if (P == Vector3::cZero)
     {
-      simplex[j] = simplex[newIndices[j]];
+      StoreSimplex(cache, simplex, directions, newSize);
+      RecordQuery(i + 1, false, false);
+      return true;
     }
 
-    CsoPoint newPoint = ComputeSupport(shapeA, shapeB, searchDirection);
+    CsoPoint newPoint = CsoSupport(shapeA, shapeB, searchDirection);
+    mStatistics.mSupportCalls += 2;
 
     if ((newPoint.mCsoPoint - P).Dot(-P.Normalized()) <= epsilon)
     {
-      closestPoint.mCsoPoint = P;
-      switch (vr)
-      {
-      case VoronoiRegion::Point0:
-      case VoronoiRegion::Point1:
-      case VoronoiRegion::Point2:
-      case VoronoiRegion::Point3:
-        closestPoint.mPointA = simplex[0].mPointA;
-        closestPoint.mPointB = simplex[0].mPointB;
-        break;
-      case VoronoiRegion::Edge01:
-      case VoronoiRegion::Edge02:
-      case VoronoiRegion::Edge03:
-      case VoronoiRegion::Edge12:
-      case VoronoiRegion::Edge13:
-      case VoronoiRegion::Edge23:
-        closestPoint.mPointA = u * simplex[0].mPointA + v * simplex[1].mPointA;
-        closestPoint.mPointB = u * simplex[0].mPointB + v * simplex[1].mPointB;
-        break;
-      case VoronoiRegion::Triangle012:
-      case VoronoiRegion::Triangle013:
-      case VoronoiRegion::Triangle023:
-      case VoronoiRegion::Triangle123:
-        closestPoint.mPointA = u * simplex[0].mPointA + v * simplex[1].mPointA + w * simplex[2].mPointA;
-        closestPoint.mPointB = u * simplex[0].mPointB + v * simplex[1].mPointB + w * simplex[2].mPointB;
-        break;
-      case VoronoiRegion::Tetrahedra0123:
-        closestPoint.mPointA = u * simplex[0].mPointA + v * simplex[1].mPointA + w * simplex[2].mPointA + t * simplex[3].mPointA;
-        closestPoint.mPointB = u * simplex[0].mPointB + v * simplex[1].mPointB + w * simplex[2].mPointB + t * simplex[3].mPointB;
-        break;
-      }
+      closestPoint = closest;
+      StoreSimplex(cache, simplex, directions, newSize);
+      RecordQuery(i + 1, true, false);
       return false;
     }
 
+    directions[newSize] = searchDirection;
     simplex[newSize++] = newPoint;
   }
+  closestPoint = closest;
+  StoreSimplex(cache, simplex, directions, newSize);
+  RecordQuery(maxIterations, false, true);
   return false;
 }
 
-Gjk::CsoPoint Gjk::ComputeSupport(const SupportShape* shapeA, const SupportShape* shapeB, const Vector3& direction)
+// Casts the shapes back to their concrete types so the matching Intersect<ShapeA, ShapeB> can be picked from a table.
+template <typename ShapeA, typename ShapeB>
+static bool IntersectAs(Gjk& gjk, const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations,
+  Gjk::CsoPoint& closestPoint, float epsilon, Gjk::SimplexCache* cache)
 {
-  CsoPoint result;
-  result.mPointA = shapeA->Support(direction);
-  result.mPointB = shapeB->Support(-direction);
-  result.mCsoPoint = result.mPointA - result.mPointB;
-  return result;
+  return gjk.Intersect(static_cast<const ShapeA*>(shapeA), static_cast<const ShapeB*>(shapeB), maxIterations, closestPoint, epsilon, cache);
+}
+
+typedef bool (*IntersectFunction)(Gjk& gjk, const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations,
+  Gjk::CsoPoint& closestPoint, float epsilon, Gjk::SimplexCache* cache);
+
+// Index into the intersect table. Only exact types count, anything deriving from a support shape
+// may override Support so it goes through the vtable with the generic SupportShape entry.
+static size_t IntersectTableIndex(const SupportShape* shape)
+{
+  const std::type_info& type = typeid(*shape);
+  if (type == typeid(ModelSupportShape))
+  {
+    return 0;
+  }
+  if (type == typeid(PointsSupportShape))
+  {
+    return 1;
+  }
+  if (type == typeid(SphereSupportShape))
+  {
+    return 2;
+  }
+  if (type == typeid(ObbSupportShape))
+  {
+    return 3;
+  }
+  return 4;
+}
+
+#define IntersectTableRow(ShapeA)                                                                           \
+  { IntersectAs<ShapeA, ModelSupportShape>, IntersectAs<ShapeA, PointsSupportShape>,                        \
+    IntersectAs<ShapeA, SphereSupportShape>, IntersectAs<ShapeA, ObbSupportShape>, IntersectAs<ShapeA, SupportShape> }
+
+static const IntersectFunction cIntersectTable[5][5] =
+{
+  IntersectTableRow(ModelSupportShape),
+  IntersectTableRow(PointsSupportShape),
+  IntersectTableRow(SphereSupportShape),
+  IntersectTableRow(ObbSupportShape),
+  IntersectTableRow(SupportShape)
+};
+
+#undef IntersectTableRow
+
+// Explicitly instantiated so other files can call Intersect<ShapeA, ShapeB> with any pair of the support shapes.
+#define InstantiateIntersect(ShapeA, ShapeB) \
+  template bool Gjk::Intersect<ShapeA, ShapeB>(const ShapeA*, const ShapeB*, unsigned int, Gjk::CsoPoint&, float, Gjk::SimplexCache*);
+#define InstantiateIntersectRow(ShapeA)                                                               \
+  InstantiateIntersect(ShapeA, ModelSupportShape) InstantiateIntersect(ShapeA, PointsSupportShape)    \
+  InstantiateIntersect(ShapeA, SphereSupportShape) InstantiateIntersect(ShapeA, ObbSupportShape)      \
+  InstantiateIntersect(ShapeA, SupportShape)
+
+InstantiateIntersectRow(ModelSupportShape)
+InstantiateIntersectRow(PointsSupportShape)
+InstantiateIntersectRow(SphereSupportShape)
+InstantiateIntersectRow(ObbSupportShape)
+InstantiateIntersectRow(SupportShape)
+
+#undef InstantiateIntersectRow
+#undef InstantiateIntersect
+
+bool Gjk::Intersect(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon, int debuggingIndex, bool debugDraw,
+  SimplexCache* cache)
+{
+  IntersectFunction intersect = cIntersectTable[IntersectTableIndex(shapeA)][IntersectTableIndex(shapeB)];
+  return intersect(*this, shapeA, shapeB, maxIterations, closestPoint, epsilon, cache);
+}
+
+bool Gjk::IntersectRelative(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint,
+  float epsilon, SimplexCache* cache)
+{
+  Vector3 origin = (shapeA->GetCenter() + shapeB->GetCenter()) * 0.5f;
+  RelativeOriginSupportShape relativeA;
+  relativeA.mShape = shapeA;
+  relativeA.mOrigin = origin;
+  RelativeOriginSupportShape relativeB;
+  relativeB.mShape = shapeB;
+  relativeB.mOrigin = origin;
+
+  // The cso points don't move with the origin (it cancels out) and the cache only holds directions.
+  // The relative point is only copied out once Intersect has written it, so the caller's point is never shifted twice.
+  CsoPoint relativePoint;
+  bool intersecting = Intersect(&relativeA, &relativeB, maxIterations, relativePoint, epsilon, -1, false, cache);
+  if (!intersecting)
+  {
+    closestPoint = relativePoint;
+    closestPoint.mPointA += origin;
+    closestPoint.mPointB += origin;
+  }
+  for (size_t i = 0; i < mSimplexSize; ++i)
+  {
+    mSimplex[i].mPointA += origin;
+    mSimplex[i].mPointB += origin;
+  }
+  return intersecting;
+}
+
+bool Gjk::Batch::Pair::operator<(const Pair& rhs) const
+{
+  if (mTypes[0] != rhs.mTypes[0])
+  {
+    return mTypes[0] < rhs.mTypes[0];
+  }
+  if (mTypes[1] != rhs.mTypes[1])
+  {
+    return mTypes[1] < rhs.mTypes[1];
+  }
+  return mPairIndex < rhs.mPairIndex;
+}
+
+void Gjk::Batch::Build(const QueryResults& pairs, GjkPairCache* cache)
+{
+  const size_t pairCount = pairs.mResults.size();
+
+  // Every model gets one support shape for the whole batch (a model usually shows up in several pairs)
+  mModels.clear();
+  for (size_t i = 0; i < pairCount; ++i)
+  {
+    mModels.push_back(static_cast<Model*>(pairs.mResults[i].mClientData0));
+    mModels.push_back(static_cast<Model*>(pairs.mResults[i].mClientData1));
+  }
+  std::sort(mModels.begin(), mModels.end());
+  mModels.erase(std::unique(mModels.begin(), mModels.end()), mModels.end());
+
+  mShapes.resize(mModels.size());
+  for (size_t i = 0; i < mModels.size(); ++i)
+  {
+    ModelSupportShape& shape = mShapes[i];
+    shape.mModel = mModels[i];
+    shape.mLastSupportVertex = 0;
+    shape.GatherTransform();
+  }
+
+  // Group pairs with the same mesh types so consecutive queries walk the same vertex data
+  mPairs.resize(pairCount);
+  for (size_t i = 0; i < pairCount; ++i)
+  {
+    const QueryResult& queryPair = pairs.mResults[i];
+    Pair& pair = mPairs[i];
+    pair.mPairIndex = i;
+    pair.mShapes[0] = static_cast<unsigned int>(std::lower_bound(mModels.begin(), mModels.end(), static_cast<Model*>(queryPair.mClientData0)) - mModels.begin());
+    pair.mShapes[1] = static_cast<unsigned int>(std::lower_bound(mModels.begin(), mModels.end(), static_cast<Model*>(queryPair.mClientData1)) - mModels.begin());
+    pair.mTypes[0] = mModels[pair.mShapes[0]]->mMesh->mType;
+    pair.mTypes[1] = mModels[pair.mShapes[1]]->mMesh->mType;
+    if (pair.mTypes[1] < pair.mTypes[0])
+    {
+      std::swap(pair.mTypes[0], pair.mTypes[1]);
+    }
+    pair.mCache = cache != nullptr ? &cache->Find(queryPair) : nullptr;
+  }
+  std::sort(mPairs.begin(), mPairs.end());
+}
+
+void Gjk::IntersectBatch(const Batch& batch, size_t begin, size_t end, unsigned int maxIterations, float epsilon, bool relativeOrigin,
+  BatchResult* results, BatchSimplex* simplices)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    const Batch::Pair& pair = batch.mPairs[i];
+    // Copies keep the gathered transforms but give each query its own hill-climbing start vertex,
+    // so ranges running on other threads never write to a shape this one reads
+    ModelSupportShape shapeA = batch.mShapes[pair.mShapes[0]];
+    ModelSupportShape shapeB = batch.mShapes[pair.mShapes[1]];
+    SimplexCache* cache = pair.mCache;
+    BatchResult& result = results[pair.mPairIndex];
+
+    // Pairs that stay apart tend to stay apart along the same axis from frame to frame
+    if (cache != nullptr && cache->mHasSeparatingAxis)
+    {
+      CsoPoint supportPoint = CsoSupport(&shapeA, &shapeB, cache->mSeparatingAxis);
+      mStatistics.mSupportCalls += 2;
+      if (Math::Dot(supportPoint.mCsoPoint, cache->mSeparatingAxis) < 0.0f)
+      {
+        ++mStatistics.mSeparatingAxisExits;
+        result.mIntersecting = false;
+        result.mHasClosestPoint = false;
+        if (simplices != nullptr)
+        {
+          simplices[pair.mPairIndex].mSize = 0;
+        }
+        continue;
+      }
+    }
+
+    CsoPoint closestPoint;
+    if (relativeOrigin)
+    {
+      result.mIntersecting = IntersectRelative(&shapeA, &shapeB, maxIterations, closestPoint, epsilon, cache);
+    }
+    else
+    {
+      result.mIntersecting = Intersect<ModelSupportShape, ModelSupportShape>(&shapeA, &shapeB, maxIterations, closestPoint, epsilon, cache);
+    }
+    result.mHasClosestPoint = true;
+    result.mDistance = 0.0f;
+    if (!result.mIntersecting)
+    {
+      result.mDistance = closestPoint.mCsoPoint.Length();
+      result.mPointA = closestPoint.mPointA;
+      result.mPointB = closestPoint.mPointB;
+    }
+
+    if (cache != nullptr)
+    {
+      // The origin is behind the plane through the closest point facing it, so the direction to the origin separates.
+      // After a bailout it may not, which only costs the two support calls next frame.
+      cache->mHasSeparatingAxis = !result.mIntersecting && closestPoint.mCsoPoint != Vector3::cZero;
+      if (cache->mHasSeparatingAxis)
+      {
+        cache->mSeparatingAxis = -closestPoint.mCsoPoint;
+      }
+    }
+
+    if (simplices != nullptr)
+    {
+      BatchSimplex& simplex = simplices[pair.mPairIndex];
+      simplex.mSize = mSimplexSize;
+      for (size_t j = 0; j < mSimplexSize; ++j)
+      {
+        simplex.mPoints[j] = mSimplex[j];
+      }
+    }
+  }
+}
+
+void Gjk::IntersectBatch(const QueryResults& pairs, unsigned int maxIterations, float epsilon, std::vector<BatchResult>& results,
+  GjkPairCache* cache)
+{
+  mBatch.Build(pairs, cache);
+  results.resize(pairs.mResults.size());
+  IntersectBatch(mBatch, 0, mBatch.mPairs.size(), maxIterations, epsilon, false, results.data());
+}
+
+float Gjk::Distance(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+  CsoPoint& closestPoint, SimplexCache* cache)
+{
+  Vector3 separatingAxis;
+  float lowerBound;
+  return DistanceQuery(shapeA, shapeB, maxIterations, epsilon, Math::PositiveMax(), false, closestPoint, separatingAxis, lowerBound, cache);
+}
+
+bool Gjk::DistanceWithin(const SupportShape* shapeA, const SupportShape* shapeB, float maxDistance, unsigned int maxIterations, float epsilon,
+  float& distance, CsoPoint& closestPoint, SimplexCache* cache)
+{
+  Vector3 separatingAxis;
+  float lowerBound;
+  distance = DistanceQuery(shapeA, shapeB, maxIterations, epsilon, maxDistance, false, closestPoint, separatingAxis, lowerBound, cache);
+  return lowerBound <= maxDistance && distance <= maxDistance;
+}
+
+bool Gjk::Separated(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+  Vector3& separatingAxis, SimplexCache* cache)
+{
+  CsoPoint closestPoint;
+  float lowerBound;
+  DistanceQuery(shapeA, shapeB, maxIterations, epsilon, Math::PositiveMax(), true, closestPoint, separatingAxis, lowerBound, cache);
+  return lowerBound > 0.0f;
+}
+
+float Gjk::DistanceQuery(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+  float maxDistance, bool stopOnSeparatingAxis, CsoPoint& closestPoint, Vector3& separatingAxis, float& lowerBound, SimplexCache* cache)
+{
+  CsoPoint simplex[4];
+  Vector3 directions[4];
+  size_t size = 0;
+  lowerBound = 0.0f;
+  separatingAxis = Vector3::cZero;
+
+  if (cache != nullptr && cache->mSize != 0)
+  {
+    size = WarmStart(shapeA, shapeB, *cache, simplex, directions);
+  }
+  if (size == 0)
+  {
+    Vector3 searchDirection = shapeA->GetCenter() - shapeB->GetCenter();
+    if (searchDirection == Vector3::cZero)
+    {
+      searchDirection = -Vector3::cXAxis;
+    }
+    searchDirection.Normalize();
+    simplex[0] = ComputeSupport(shapeA, shapeB, searchDirection);
+    directions[0] = searchDirection;
+    size = 1;
+  }
+
+  float upperBound = Math::PositiveMax();
+  size_t iterations = 0;
+  bool epsilonExit = false;
+  bool stoppedEarly = false;
+  for (size_t i = 0; i < maxIterations; ++i)
+  {
+    ++iterations;
+    Vector3 searchDirection;
+    if (ReduceSimplex(simplex, directions, size, closestPoint, searchDirection))
+    {
+      ++mStatistics.mDegenerateSimplices;
+    }
+    Vector3 P = closestPoint.mCsoPoint;
+
+    upperBound = P.Length();
+    if (upperBound == 0.0f)
+    {
+      lowerBound = 0.0f;
+      stoppedEarly = true;
+      break;
+    }
+
+    // Every cso point x has Dot(x, -P) <= Dot(support, -P), so the plane through the
+    // support point facing the origin bounds the distance from below.
+    searchDirection = -P / upperBound;
+    CsoPoint newPoint = ComputeSupport(shapeA, shapeB, searchDirection);
+    float separation = -Math::Dot(newPoint.mCsoPoint, searchDirection);
+    if (lowerBound < separation)
+    {
+      lowerBound = separation;
+    }
+
+    // A positive separation means the cso lies entirely on one side of the plane (B is further along the axis than A)
+    if (stopOnSeparatingAxis && separation > 0.0f)
+    {
+      separatingAxis = searchDirection;
+      stoppedEarly = true;
+      break;
+    }
+    if (upperBound - lowerBound <= epsilon)
+    {
+      epsilonExit = true;
+      break;
+    }
+    if (lowerBound > maxDistance)
+    {
+      stoppedEarly = true;
+      break;
+    }
+
+    directions[size] = searchDirection;
+    simplex[size++] = newPoint;
+  }
+
+  if (lowerBound > 0.0f && separatingAxis == Vector3::cZero)
+  {
+    separatingAxis = -closestPoint.mCsoPoint.Normalized();
+  }
+  StoreSimplex(cache, simplex, directions, size);
+  RecordQuery(iterations, epsilonExit, !epsilonExit && !stoppedEarly);
+  return upperBound;
+}
+
+//-----------------------------------------------------------------------------Time of impact
+// A shape moved along a Gjk::Motion to some time. Only directions and the winning point are transformed.
+class MotionSupportShape : public SupportShape
+{
+public:
+  MotionSupportShape(const SupportShape* shape, const Gjk::Motion& motion)
+  {
+    mShape = shape;
+    mMotion = &motion;
+    mCenter = shape->GetCenter();
+    SetTime(0.0f);
+  }
+
+  void SetTime(float time)
+  {
+    mRotation = Matrix3::cIdentity;
+    float angularSpeed = mMotion->mAngularVelocity.Length();
+    if (angularSpeed > 0.0f)
+    {
+      mRotation = Math::ToMatrix3(mMotion->mAngularVelocity / angularSpeed, angularSpeed * time);
+    }
+    mOffset = mMotion->mLinearVelocity * time;
+  }
+
+  Vector3 GetCenter() const override
+  {
+    return mCenter + mOffset;
+  }
+
+  Vector3 Support(const Vector3& worldDirection) const override
+  {
+    Vector3 point = mShape->Support(Math::TransposedTransform(mRotation, worldDirection));
+    return Math::Transform(mRotation, point - mCenter) + mCenter + mOffset;
+  }
+
+  // Draws the shape where it starts
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override
+  {
+    mShape->DebugDraw(color);
+  }
+
+private:
+  const SupportShape* mShape;
+  const Gjk::Motion* mMotion;
+  Vector3 mCenter;
+  Matrix3 mRotation;
+  Vector3 mOffset;
+};
+
+// Upper bound on how far any point of the shape is from the center (the furthest corner of the aabb spanned by the axis supports).
+static float BoundingRadius(const SupportShape* shape, const Vector3& center)
+{
+  Vector3 extents;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    Vector3 axis = Vector3::cZero;
+    axis[i] = 1.0f;
+    float positive = Math::Dot(shape->Support(axis) - center, axis);
+    float negative = Math::Dot(center - shape->Support(-axis), axis);
+    extents[i] = Math::Max(positive, negative);
+  }
+  return extents.Length();
+}
+
+Gjk::Motion::Motion()
+{
+  mLinearVelocity = Vector3::cZero;
+  mAngularVelocity = Vector3::cZero;
+}
+
+bool Gjk::TimeOfImpact(const SupportShape* shapeA, const Motion& motionA, const SupportShape* shapeB, const Motion& motionB,
+  float maxTime, float tolerance, unsigned int maxSteps, unsigned int maxIterations, float epsilon, ImpactInfo& info)
+{
+  MotionSupportShape movingA(shapeA, motionA);
+  MotionSupportShape movingB(shapeB, motionB);
+
+  // Spinning moves no point of a shape faster than its angular speed times its bounding radius
+  Vector3 relativeVelocity = motionB.mLinearVelocity - motionA.mLinearVelocity;
+  float angularBound = motionA.mAngularVelocity.Length() * BoundingRadius(shapeA, movingA.GetCenter()) +
+    motionB.mAngularVelocity.Length() * BoundingRadius(shapeB, movingB.GetCenter());
+
+  info.mNormal = Vector3::cZero;
+  SimplexCache cache;
+  float time = 0.0f;
+  for (unsigned int i = 0; i < maxSteps; ++i)
+  {
+    movingA.SetTime(time);
+    movingB.SetTime(time);
+
+    CsoPoint closestPoint;
+    Vector3 separatingAxis;
+    float lowerBound;
+    float distance = DistanceQuery(&movingA, &movingB, maxIterations, epsilon, Math::PositiveMax(), false, closestPoint, separatingAxis,
+      lowerBound, &cache);
+    info.mTime = time;
+    info.mPointA = closestPoint.mPointA;
+    info.mPointB = closestPoint.mPointB;
+    // The normal comes from this query when it has one. Shapes that ended up touching give neither an axis
+    // nor a direction between their points, so those keep the axis of the step that brought them together.
+    if (separatingAxis != Vector3::cZero)
+    {
+      info.mNormal = separatingAxis;
+    }
+    else if (distance > 0.0f)
+    {
+      info.mNormal = (closestPoint.mPointB - closestPoint.mPointA).Normalized();
+    }
+    // Stepping by the distance could overshoot if the query stopped short of converging, only the lower bound is safe.
+    // Without one there's no safe step to take, so the shapes are treated as touching now rather than risk passing through.
+    if (distance <= tolerance || lowerBound <= 0.0f)
+    {
+      return true;
+    }
+
+    float closingSpeed = -Math::Dot(relativeVelocity, separatingAxis) + angularBound;
+    if (closingSpeed <= 0.0f)
+    {
+      return false;
+    }
+
+    time += lowerBound / closingSpeed;
+    if (time > maxTime)
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------Ray cast
+bool Gjk::RayCast(const SupportShape* shape, const Ray& ray, float maxT, unsigned int maxIterations, float epsilon, float& t, Vector3& normal)
+{
+  // The simplex lives in the space of x - shape (x being the ray's current point), so mPointA holds the point
+  // on the shape and mCsoPoint is rebuilt whenever x moves. The directions are only there for ReduceSimplex.
+  CsoPoint simplex[4];
+  Vector3 directions[4];
+  size_t size = 0;
+
+  t = 0.0f;
+  normal = Vector3::cZero;
+  Vector3 x = ray.mStart;
+  Vector3 v = x - shape->GetCenter();
+
+  size_t iterations = 0;
+  for (; iterations < maxIterations && v.LengthSq() > epsilon * epsilon; ++iterations)
+  {
+    Vector3 p = shape->Support(v);
+    ++mStatistics.mSupportCalls;
+    Vector3 w = x - p;
+    float vDotW = Math::Dot(v, w);
+    if (vDotW > 0.0f)
+    {
+      // v separates x from the shape, so the ray has to move up to the plane through p (or it misses)
+      float vDotR = Math::Dot(v, ray.mDirection);
+      if (vDotR >= 0.0f)
+      {
+        RecordQuery(iterations + 1, false, false);
+        return false;
+      }
+      t -= vDotW / vDotR;
+      if (t > maxT)
+      {
+        RecordQuery(iterations + 1, false, false);
+        return false;
+      }
+      x = ray.GetPoint(t);
+      normal = v;
+      for (size_t j = 0; j < size; ++j)
+      {
+        simplex[j].mCsoPoint = x - simplex[j].mPointA;
+      }
+    }
+
+    simplex[size].mPointA = p;
+    simplex[size].mPointB = Vector3::cZero;
+    simplex[size].mCsoPoint = x - p;
+    directions[size] = v;
+    ++size;
+
+    CsoPoint closestPoint;
+    Vector3 searchDirection;
+    if (ReduceSimplex(simplex, directions, size, closestPoint, searchDirection))
+    {
+      ++mStatistics.mDegenerateSimplices;
+    }
+    v = closestPoint.mCsoPoint;
+  }
+  bool converged = v.LengthSq() <= epsilon * epsilon;
+  RecordQuery(iterations, converged, !converged);
+
+  // Running out of iterations leaves x short of the shape, which isn't a hit
+  if (!converged)
+  {
+    return false;
+  }
+
+  if (normal != Vector3::cZero)
+  {
+    normal.Normalize();
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------Shape cast
+// The cso of two shapes (B - A), so that casting A into B becomes a ray cast from the origin.
+class CsoSupportShape : public SupportShape
+{
+public:
+  CsoSupportShape(const SupportShape* shapeA, const SupportShape* shapeB)
+  {
+    mShapeA = shapeA;
+    mShapeB = shapeB;
+  }
+
+  Vector3 GetCenter() const override
+  {
+    return mShapeB->GetCenter() - mShapeA->GetCenter();
+  }
+
+  Vector3 Support(const Vector3& worldDirection) const override
+  {
+    return mShapeB->Support(worldDirection) - mShapeA->Support(-worldDirection);
+  }
+
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override
+  {
+  }
+
+private:
+  const SupportShape* mShapeA;
+  const SupportShape* mShapeB;
+};
+
+bool Gjk::ShapeCast(const SupportShape* shapeA, const Vector3& sweep, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+  float& t, Vector3& normal)
+{
+  CsoSupportShape cso(shapeA, shapeB);
+  return RayCast(&cso, Ray(Vector3::cZero, sweep), 1.0f, maxIterations, epsilon, t, normal);
+}
+
+// Iterations and tolerance for the spatial partitions' shape casts
+static const unsigned int cCastIterations = 32;
+static const float cCastEpsilon = 0.0001f;
+
+bool ShapeCastAabb(Gjk& gjk, const SupportShape& shape, const Vector3& sweep, const Aabb& aabb, float& t)
+{
+  ObbSupportShape box;
+  box.mScale = aabb.mMax - aabb.mMin;
+  box.mRotation = Matrix3::cIdentity;
+  box.mTranslation = aabb.GetCenter();
+
+  Vector3 normal;
+  return gjk.ShapeCast(&shape, sweep, &box, cCastIterations, cCastEpsilon, t, normal);
+}
+
+bool ShapeCastSphere(Gjk& gjk, const SupportShape& shape, const Vector3& sweep, const Sphere& sphere, float& t)
+{
+  SphereSupportShape sphereShape;
+  sphereShape.mSphere = sphere;
+
+  Vector3 normal;
+  return gjk.ShapeCast(&shape, sweep, &sphereShape, cCastIterations, cCastEpsilon, t, normal);
+}
+
+//-----------------------------------------------------------------------------Signed volumes
+// Johnson's sub-simplex solver written with signed volumes (Montanari et al). Each solver finds the
+// feature closest to the origin along with its barycentric weights, only recursing into the sub-features
+// whose weight came out non-positive. The weights are ratios of signed volumes (areas, lengths) that share
+// the same determinants, so nothing is recomputed between regions and nothing needs normalizing.
+struct SubSimplex
+{
+  size_t mSize;
+  int mIndices[4];
+  float mWeights[4];
+};
+
+static Vector3 SubSimplexPoint(const Vector3 points[4], const SubSimplex& subSimplex)
+{
+  Vector3 result = Vector3::cZero;
+  for (size_t i = 0; i < subSimplex.mSize; ++i)
+  {
+    result += subSimplex.mWeights[i] * points[subSimplex.mIndices[i]];
+  }
+  return result;
+}
+
+static void SolvePoint(int i0, SubSimplex& result)
+{
+  result.mSize = 1;
+  result.mIndices[0] = i0;
+  result.mWeights[0] = 1.0f;
+}
+
+static void SolveSegment(const Vector3 points[4], int i0, int i1, SubSimplex& result)
+{
+  const Vector3& a = points[i0];
+  const Vector3& b = points[i1];
+  Vector3 edge = b - a;
+  float lengthSq = edge.LengthSq();
+  if (lengthSq == 0.0f)
+  {
+    SolvePoint(i0, result);
+    return;
+  }
+
+  // Work on the axis the segment is longest along, the origin's projection splits it into the two weights
+  Vector3 projection = a - edge * (Math::Dot(a, edge) / lengthSq);
+  int axis = 0;
+  if (Math::Abs(edge[1]) > Math::Abs(edge[axis])) axis = 1;
+  if (Math::Abs(edge[2]) > Math::Abs(edge[axis])) axis = 2;
+  float length = b[axis] - a[axis];
+  float weight0 = (b[axis] - projection[axis]) / length;
+  float weight1 = (projection[axis] - a[axis]) / length;
+
+  if (weight1 <= 0.0f)
+  {
+    SolvePoint(i0, result);
+  }
+  else if (weight0 <= 0.0f)
+  {
+    SolvePoint(i1, result);
+  }
+  else
+  {
+    result.mSize = 2;
+    result.mIndices[0] = i0;
+    result.mIndices[1] = i1;
+    result.mWeights[0] = weight0;
+    result.mWeights[1] = weight1;
+  }
+}
+
+// Returns false if the triangle was too flat to solve directly (only its edges were checked).
+static bool SolveTriangle(const Vector3 points[4], int i0, int i1, int i2, SubSimplex& result)
+{
+  const Vector3& a = points[i0];
+  const Vector3& b = points[i1];
+  const Vector3& c = points[i2];
+  Vector3 normal = Math::Cross(b - a, c - a);
+  float normalLengthSq = normal.LengthSq();
+  float flatLengthSq = cFlatEpsilon * cFlatEpsilon * (b - a).LengthSq() * (c - a).LengthSq();
+
+  float weights[3] = { -1.0f, -1.0f, -1.0f };
+  if (normalLengthSq > flatLengthSq)
+  {
+    // Project onto the coordinate plane where the triangle has the largest area. Using the
+    // cyclic axis pair means the projected area is exactly that component of the normal.
+    Vector3 projection = normal * (Math::Dot(a, normal) / normalLengthSq);
+    int k = 0;
+    if (Math::Abs(normal[1]) > Math::Abs(normal[k])) k = 1;
+    if (Math::Abs(normal[2]) > Math::Abs(normal[k])) k = 2;
+    int x = (k + 1) % 3;
+    int y = (k + 2) % 3;
+    Vector3 pa = a - projection;
+    Vector3 pb = b - projection;
+    Vector3 pc = c - projection;
+    weights[0] = (pb[x] * pc[y] - pb[y] * pc[x]) / normal[k];
+    weights[1] = (pc[x] * pa[y] - pc[y] * pa[x]) / normal[k];
+    weights[2] = (pa[x] * pb[y] - pa[y] * pb[x]) / normal[k];
+
+    if (weights[0] > 0.0f && weights[1] > 0.0f && weights[2] > 0.0f)
+    {
+      result.mSize = 3;
+      result.mIndices[0] = i0;
+      result.mIndices[1] = i1;
+      result.mIndices[2] = i2;
+      result.mWeights[0] = weights[0];
+      result.mWeights[1] = weights[1];
+      result.mWeights[2] = weights[2];
+      return true;
+    }
+  }
+
+  // Otherwise the closest point is on an edge opposite a non-positive weight (a degenerate triangle checks them all)
+  const int indices[3] = { i0, i1, i2 };
+  float bestDistanceSq = Math::PositiveMax();
+  for (int j = 0; j < 3; ++j)
+  {
+    if (weights[j] > 0.0f)
+    {
+      continue;
+    }
+    SubSimplex edge;
+    SolveSegment(points, indices[(j + 1) % 3], indices[(j + 2) % 3], edge);
+    float distanceSq = SubSimplexPoint(points, edge).LengthSq();
+    if (distanceSq < bestDistanceSq)
+    {
+      bestDistanceSq = distanceSq;
+      result = edge;
+    }
+  }
+  return normalLengthSq > flatLengthSq;
+}
+
+// Returns false if the tetrahedron was too flat to solve directly (only its faces were checked).
+static bool SolveTetrahedron(const Vector3 points[4], SubSimplex& result)
+{
+  const Vector3& p0 = points[0];
+  const Vector3& p1 = points[1];
+  const Vector3& p2 = points[2];
+  const Vector3& p3 = points[3];
+
+  // The volume with vertex j swapped for the origin, over the full volume, is vertex j's weight.
+  // All four are triple products built from two shared cross products.
+  Vector3 cross23 = Math::Cross(p2, p3);
+  Vector3 cross01 = Math::Cross(p0, p1);
+  float volumes[4];
+  volumes[0] = Math::Dot(p1, cross23);
+  volumes[1] = -Math::Dot(p0, cross23);
+  volumes[2] = Math::Dot(p3, cross01);
+  volumes[3] = -Math::Dot(p2, cross01);
+  float volume = volumes[0] + volumes[1] + volumes[2] + volumes[3];
+  // When the sub-volumes mostly cancel the total is round off and so are the weights
+  float flatVolume = cFlatEpsilon * (Math::Abs(volumes[0]) + Math::Abs(volumes[1]) + Math::Abs(volumes[2]) + Math::Abs(volumes[3]));
+
+  float weights[4] = { -1.0f, -1.0f, -1.0f, -1.0f };
+  if (Math::Abs(volume) > flatVolume)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      weights[j] = volumes[j] / volume;
+    }
+    // The origin touching a face still counts as contained
+    if (weights[0] >= 0.0f && weights[1] >= 0.0f && weights[2] >= 0.0f && weights[3] >= 0.0f)
+    {
+      result.mSize = 4;
+      for (int j = 0; j < 4; ++j)
+      {
+        result.mIndices[j] = j;
+        result.mWeights[j] = weights[j];
+      }
+      return true;
+    }
+  }
+
+  // Check the faces opposite negative weights (all of them for a flat tetrahedron)
+  static const int faces[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+  float bestDistanceSq = Math::PositiveMax();
+  for (int j = 0; j < 4; ++j)
+  {
+    if (weights[j] >= 0.0f)
+    {
+      continue;
+    }
+    SubSimplex face;
+    SolveTriangle(points, faces[j][0], faces[j][1], faces[j][2], face);
+    float distanceSq = SubSimplexPoint(points, face).LengthSq();
+    if (distanceSq < bestDistanceSq)
+    {
+      bestDistanceSq = distanceSq;
+      result = face;
+    }
+  }
+  return Math::Abs(volume) > flatVolume;
+}
+
+bool Gjk::ReduceSimplex(CsoPoint simplex[4], Vector3 directions[4], size_t& size, CsoPoint& closestPoint, Vector3& searchDirection)
+{
+  Vector3 points[4];
+  for (size_t i = 0; i < size; ++i)
+  {
+    points[i] = simplex[i].mCsoPoint;
+  }
+
+  SubSimplex subSimplex;
+  bool solved = true;
+  switch (size)
+  {
+  case 1:
+    SolvePoint(0, subSimplex);
+    break;
+  case 2:
+    SolveSegment(points, 0, 1, subSimplex);
+    break;
+  case 3:
+    solved = SolveTriangle(points, 0, 1, 2, subSimplex);
+    break;
+  default:
+    solved = SolveTetrahedron(points, subSimplex);
+    break;
+  }
+
+  // The weights reconstruct the closest points on each object as well as on the cso
+  CsoPoint reduced[4];
+  Vector3 reducedDirections[4];
+  closestPoint.mPointA = Vector3::cZero;
+  closestPoint.mPointB = Vector3::cZero;
+  closestPoint.mCsoPoint = Vector3::cZero;
+  for (size_t i = 0; i < subSimplex.mSize; ++i)
+  {
+    const CsoPoint& point = simplex[subSimplex.mIndices[i]];
+    float weight = subSimplex.mWeights[i];
+    closestPoint.mPointA += weight * point.mPointA;
+    closestPoint.mPointB += weight * point.mPointB;
+    closestPoint.mCsoPoint += weight * point.mCsoPoint;
+    reduced[i] = point;
+    reducedDirections[i] = directions[subSimplex.mIndices[i]];
+  }
+
+  size = subSimplex.mSize;
+  for (size_t i = 0; i < size; ++i)
+  {
+    simplex[i] = reduced[i];
+    directions[i] = reducedDirections[i];
+  }
+
+  // A full tetrahedron contains the origin, don't let round off in the weights say otherwise. The same goes for the origin
+  // lying on a flat simplex (e.g. between mirror symmetric shapes): the closest point is then round off in the simplex's
+  // plane, and searching along it would never leave that plane.
+  float sizeSq = 0.0f;
+  for (size_t i = 0; i < size; ++i)
+  {
+    sizeSq = Math::Max(sizeSq, simplex[i].mCsoPoint.LengthSq());
+  }
+  if (size == 4 || closestPoint.mCsoPoint.LengthSq() <= cDegenerateEpsilon * cDegenerateEpsilon * sizeSq)
+  {
+    closestPoint.mCsoPoint = Vector3::cZero;
+  }
+  searchDirection = -closestPoint.mCsoPoint;
+  return !solved;
+}
+
+Gjk::CsoPoint Gjk::ComputeSupport(const SupportShape* shapeA, const SupportShape* shapeB, const Vector3& direction)
+{
+  mStatistics.mSupportCalls += 2;
+  return CsoSupport(shapeA, shapeB, direction);
+}
+
+bool Gjk::SeparatedAlong(const SupportShape* shapeA, const SupportShape* shapeB, const Vector3& direction, CsoPoint& supportPoint)
+{
+  supportPoint = ComputeSupport(shapeA, shapeB, direction);
+  return Math::Dot(supportPoint.mCsoPoint, direction) < 0.0f;
+}
+
+template <typename ShapeA, typename ShapeB>
+size_t Gjk::WarmStart(const ShapeA* shapeA, const ShapeB* shapeB, const SimplexCache& cache, CsoPoint simplex[4], Vector3 directions[4])
+{
+  size_t size = 0;
+
+  for (size_t i = 0; i < cache.mSize; ++i)
+  {
+    simplex[size] = CsoSupport(shapeA, shapeB, cache.mDirections[i]);
+    mStatistics.mSupportCalls += 2;
+    directions[size] = cache.mDirections[i];
+
+    // The voronoi region tests expect a non-degenerate simplex, so only keep
+    // points that add a new dimension to what has been rebuilt so far.
+    bool degenerate = false;
+    if (size == 1)
+    {
+      degenerate = (simplex[1].mCsoPoint - simplex[0].mCsoPoint).LengthSq() < cDegenerateEpsilon;
+    }
+    else if (size == 2)
+    {
+      Vector3 normal = Math::Cross(simplex[1].mCsoPoint - simplex[0].mCsoPoint, simplex[2].mCsoPoint - simplex[0].mCsoPoint);
+      degenerate = normal.LengthSq() < cDegenerateEpsilon;
+    }
+    else if (size == 3)
+    {
+      Vector3 normal = Math::Cross(simplex[1].mCsoPoint - simplex[0].mCsoPoint, simplex[2].mCsoPoint - simplex[0].mCsoPoint);
+      degenerate = Math::Abs(Math::Dot(normal, simplex[3].mCsoPoint - simplex[0].mCsoPoint)) < cDegenerateEpsilon;
+    }
+
+    if (!degenerate)
+    {
+      ++size;
+    }
+    else
+    {
+      ++mStatistics.mDegenerateSimplices;
+    }
+  }
+  return size;
+}
+
+void Gjk::StoreSimplex(SimplexCache* cache, const CsoPoint simplex[4], const Vector3 directions[4], size_t size)
+{
+  mSimplexSize = size;
+  for (size_t i = 0; i < size; ++i)
+  {
+    mSimplex[i] = simplex[i];
+  }
+
+  if (cache == nullptr)
+  {
+    return;
+  }
+  cache->mSize = size;
+  for (size_t i = 0; i < size; ++i)
+  {
+    cache->mDirections[i] = directions[i];
+  }
+}
+
+//-----------------------------------------------------------------------------Epa
+bool Gjk::EpaPolytope::AddFace(size_t i0, size_t i1, size_t i2)
+{
+  if (mFaceCount == cMaxFaces)
+  {
+    return false;
+  }
+
+  EpaFace& face = mFaces[mFaceCount++];
+  face.mIndices[0] = i0;
+  face.mIndices[1] = i1;
+  face.mIndices[2] = i2;
+
+  const Vector3& p0 = mVertices[i0].mCsoPoint;
+  face.mNormal = Math::Cross(mVertices[i1].mCsoPoint - p0, mVertices[i2].mCsoPoint - p0);
+  float length = face.mNormal.Length();
+  if (length < cDegenerateEpsilon)
+  {
+    // A sliver can't give a meaningful normal (and could never be seen to remove it later), so drop it
+    --mFaceCount;
+    return true;
+  }
+  face.mNormal /= length;
+  face.mDistance = Math::Dot(face.mNormal, p0);
+  return true;
+}
+
+bool Gjk::EpaPolytope::AddHorizonEdge(size_t i0, size_t i1)
+{
+  for (size_t i = 0; i < mEdgeCount; ++i)
+  {
+    if (mEdges[i].mIndices[0] == i1 && mEdges[i].mIndices[1] == i0)
+    {
+      mEdges[i] = mEdges[--mEdgeCount];
+      return true;
+    }
+  }
+
+  if (mEdgeCount == cMaxEdges)
+  {
+    return false;
+  }
+  mEdges[mEdgeCount].mIndices[0] = i0;
+  mEdges[mEdgeCount].mIndices[1] = i1;
+  ++mEdgeCount;
+  return true;
+}
+
+bool Gjk::EpaPolytope::IsVisible(const EpaFace& face, const Vector3& point) const
+{
+  return Math::Dot(face.mNormal, point - mVertices[face.mIndices[0]].mCsoPoint) > 0.0f;
+}
+
+size_t Gjk::EpaPolytope::ClosestFace() const
+{
+  size_t closest = 0;
+  for (size_t i = 1; i < mFaceCount; ++i)
+  {
+    if (mFaces[i].mDistance < mFaces[closest].mDistance)
+    {
+      closest = i;
+    }
+  }
+  return closest;
+}
+
+bool Gjk::BuildTetrahedron(const SupportShape* shapeA, const SupportShape* shapeB)
+{
+  CsoPoint* vertices = mPolytope.mVertices;
+  size_t& count = mPolytope.mVertexCount;
+
+  // Intersect can stop on a point, edge or triangle when the origin lies on it.
+  // Search in directions that add a new dimension until the simplex is a tetrahedron.
+  if (count == 1)
+  {
+    const Vector3 axes[6] = { Vector3::cXAxis, -Vector3::cXAxis, Vector3::cYAxis, -Vector3::cYAxis, Vector3::cZAxis, -Vector3::cZAxis };
+    for (size_t i = 0; i < 6 && count == 1; ++i)
+    {
+      vertices[1] = ComputeSupport(shapeA, shapeB, axes[i]);
+      if ((vertices[1].mCsoPoint - vertices[0].mCsoPoint).LengthSq() > cDegenerateEpsilon)
+      {
+        count = 2;
+      }
+    }
+  }
+
+  if (count == 2)
+  {
+    Vector3 edge = vertices[1].mCsoPoint - vertices[0].mCsoPoint;
+    // Cross with the axis the edge is least aligned with to get a stable perpendicular
+    float x = Math::Abs(edge.x);
+    float y = Math::Abs(edge.y);
+    float z = Math::Abs(edge.z);
+    Vector3 axis = Vector3::cXAxis;
+    if (y < x && y <= z)
+    {
+      axis = Vector3::cYAxis;
+    }
+    else if (z < x && z < y)
+    {
+      axis = Vector3::cZAxis;
+    }
+    Vector3 perp0 = Math::Cross(edge, axis).Normalized();
+    Vector3 perp1 = Math::Cross(edge, perp0).Normalized();
+    const Vector3 directions[4] = { perp0, -perp0, perp1, -perp1 };
+    for (size_t i = 0; i < 4 && count == 2; ++i)
+    {
+      vertices[2] = ComputeSupport(shapeA, shapeB, directions[i]);
+      if (Math::Cross(edge, vertices[2].mCsoPoint - vertices[0].mCsoPoint).LengthSq() > cDegenerateEpsilon)
+      {
+        count = 3;
+      }
+    }
+  }
+
+  if (count == 3)
+  {
+    Vector3 normal = Math::Cross(vertices[1].mCsoPoint - vertices[0].mCsoPoint, vertices[2].mCsoPoint - vertices[0].mCsoPoint);
+    const Vector3 directions[2] = { normal, -normal };
+    for (size_t i = 0; i < 2 && count == 3; ++i)
+    {
+      vertices[3] = ComputeSupport(shapeA, shapeB, directions[i]);
+      if (Math::Abs(Math::Dot(normal, vertices[3].mCsoPoint - vertices[0].mCsoPoint)) > cDegenerateEpsilon)
+      {
+        count = 4;
+      }
+    }
+  }
+
+  return count == 4;
+}
+
+bool Gjk::Epa(const SupportShape* shapeA, const SupportShape* shapeB, const CsoPoint simplex[4], size_t simplexSize,
+  unsigned int maxIterations, float epsilon, PenetrationInfo& info)
+{
+  EpaPolytope& polytope = mPolytope;
+  polytope.mVertexCount = 0;
+  polytope.mFaceCount = 0;
+  polytope.mEdgeCount = 0;
+
+  if (simplexSize == 0)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < simplexSize; ++i)
+  {
+    polytope.mVertices[polytope.mVertexCount++] = simplex[i];
+  }
+  if (!BuildTetrahedron(shapeA, shapeB))
+  {
+    return false;
+  }
+
+  // Wind the tetrahedron so that all face normals point outwards
+  CsoPoint* vertices = polytope.mVertices;
+  Vector3 normal = Math::Cross(vertices[1].mCsoPoint - vertices[0].mCsoPoint, vertices[2].mCsoPoint - vertices[0].mCsoPoint);
+  if (Math::Dot(normal, vertices[3].mCsoPoint - vertices[0].mCsoPoint) > 0.0f)
+  {
+    std::swap(vertices[1], vertices[2]);
+  }
+  polytope.AddFace(0, 1, 2);
+  polytope.AddFace(0, 3, 1);
+  polytope.AddFace(0, 2, 3);
+  polytope.AddFace(1, 3, 2);
+  if (polytope.mFaceCount == 0)
+  {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < maxIterations; ++i)
+  {
+    const EpaFace& closestFace = polytope.mFaces[polytope.ClosestFace()];
+    CsoPoint newPoint = ComputeSupport(shapeA, shapeB, closestFace.mNormal);
+
+    // The boundary of the CSO has been reached in this direction
+    if (Math::Dot(newPoint.mCsoPoint, closestFace.mNormal) - closestFace.mDistance <= epsilon)
+    {
+      break;
+    }
+    if (polytope.mVertexCount == EpaPolytope::cMaxVertices)
+    {
+      break;
+    }
+
+    // Find the boundary of the faces the new point can see before touching the polytope. If the horizon or
+    // the faces patching it won't fit then stop here with the polytope still closed and use its closest face.
+    polytope.mEdgeCount = 0;
+    size_t visibleCount = 0;
+    bool overflow = false;
+    for (size_t j = 0; j < polytope.mFaceCount && !overflow; ++j)
+    {
+      const EpaFace& face = polytope.mFaces[j];
+      if (polytope.IsVisible(face, newPoint.mCsoPoint))
+      {
+        ++visibleCount;
+        overflow = !polytope.AddHorizonEdge(face.mIndices[0], face.mIndices[1]) ||
+          !polytope.AddHorizonEdge(face.mIndices[1], face.mIndices[2]) ||
+          !polytope.AddHorizonEdge(face.mIndices[2], face.mIndices[0]);
+      }
+    }
+    if (overflow || polytope.mFaceCount - visibleCount + polytope.mEdgeCount > EpaPolytope::cMaxFaces)
+    {
+      break;
+    }
+
+    size_t newIndex = polytope.mVertexCount++;
+    vertices[newIndex] = newPoint;
+
+    // Remove every face the new point can see
+    size_t faceIndex = 0;
+    while (faceIndex < polytope.mFaceCount)
+    {
+      EpaFace& face = polytope.mFaces[faceIndex];
+      if (polytope.IsVisible(face, newPoint.mCsoPoint))
+      {
+        face = polytope.mFaces[--polytope.mFaceCount];
+      }
+      else
+      {
+        ++faceIndex;
+      }
+    }
+
+    // Patch the hole with faces fanning out from the new point (there's room for all of them from the check above)
+    for (size_t j = 0; j < polytope.mEdgeCount; ++j)
+    {
+      polytope.AddFace(polytope.mEdges[j].mIndices[0], polytope.mEdges[j].mIndices[1], newIndex);
+    }
+
+    if (polytope.mFaceCount == 0)
+    {
+      return false;
+    }
+  }
+
+  const EpaFace& face = polytope.mFaces[polytope.ClosestFace()];
+  info.mNormal = face.mNormal;
+  info.mDepth = face.mDistance;
+
+  // The origin's projection onto the closest face gives the weights for the deepest points
+  const CsoPoint& p0 = vertices[face.mIndices[0]];
+  const CsoPoint& p1 = vertices[face.mIndices[1]];
+  const CsoPoint& p2 = vertices[face.mIndices[2]];
+  float u0 = 1.0f, u1 = 0.0f, u2 = 0.0f;
+  BarycentricCoordinates(face.mNormal * face.mDistance, p0.mCsoPoint, p1.mCsoPoint, p2.mCsoPoint, u0, u1, u2);
+  info.mPointA = u0 * p0.mPointA + u1 * p1.mPointA + u2 * p2.mPointA;
+  info.mPointB = u0 * p0.mPointB + u1 * p1.mPointB + u2 * p2.mPointB;
+  return true;
+}
+
+//-----------------------------------------------------------------------------GjkPairCache
+Gjk::SimplexCache& GjkPairCache::Find(const QueryResult& pair)
+{
+  Entry& entry = mPairs[pair];
+  entry.mUsed = true;
+  return entry.mCache;
+}
+
+void GjkPairCache::Prune()
+{
+  PairMap::iterator it = mPairs.begin();
+  while (it != mPairs.end())
+  {
+    if (it->second.mUsed)
+    {
+      it->second.mUsed = false;
+      ++it;
+    }
+    else
+    {
+      it = mPairs.erase(it);
+    }
+  }
+}
+
+void GjkPairCache::Clear()
+{
+  mPairs.clear();
+}
+
+//-----------------------------------------------------------------------------GjkNarrowphase
+GjkNarrowphase::GjkNarrowphase()
+{
+  mChunkSize = 64;
+  mRelativeOrigin = false;
+  mSolvers.resize(mPool.GetWorkerCount());
+}
+
+WorkerPool& GjkNarrowphase::GetWorkerPool()
+{
+  return mPool;
+}
+
+void GjkNarrowphase::Intersect(const QueryResults& pairs, GjkPairCache& cache, unsigned int maxIterations, float epsilon)
+{
+  const size_t pairCount = pairs.mResults.size();
+  mResults.resize(pairCount);
+  mSimplices.resize(pairCount);
+
+  // Gathers every model's transform once and looks up every pair's cache before the workers start
+  mBatch.Build(pairs, &cache);
+
+  for (size_t i = 0; i < mSolvers.size(); ++i)
+  {
+    mSolvers[i].mStatistics.Clear();
+  }
+
+  // Chunks run over the sorted pairs, so a worker's pairs mostly share their mesh types
+  mPool.ParallelFor(pairCount, mChunkSize, [&](size_t begin, size_t end, size_t workerIndex)
+  {
+    mSolvers[workerIndex].IntersectBatch(mBatch, begin, end, maxIterations, epsilon, mRelativeOrigin, mResults.data(), mSimplices.data());
+  });
+
+  mStatistics.Clear();
+  for (size_t i = 0; i < mSolvers.size(); ++i)
+  {
+    mStatistics.Add(mSolvers[i].mStatistics);
+  }
 }
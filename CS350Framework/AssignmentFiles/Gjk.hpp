@@ -13,8 +13,45 @@ End Header -------------------------------------------------------*/
 #include "Math/Math.hpp"
 #include "Shapes.hpp"
 #include "DebugDraw.hpp"
+#include "SpatialPartition.hpp"
+#include "WorkerPool.hpp"
+#include <map>
 
 class Model;
+class GjkPairCache;
+
+//-----------------------------------------------------------------------------SupportTransform
+// A support shape's local to world transform plus what's needed to bring search directions into local space.
+// Only rebuilt when the scale, rotation or translation it was built from change.
+class SupportTransform
+{
+public:
+  SupportTransform();
+
+  void Update(const Vector3& scale, const Matrix3& rotation, const Vector3& translation);
+  void Update(const Vector3& scale, const Quaternion& rotation, const Vector3& translation);
+
+  // Dot(M * p, d) == Dot(p, transpose(M) * d), so a direction only needs the transposed linear part.
+  Vector3 ToLocalDirection(const Vector3& worldDirection) const;
+  Vector3 ToWorldPoint(const Vector3& localPoint) const;
+  // ToWorldPoint(localPoint) - origin, with the translation offset by origin before the local point is added so
+  // points far from the world origin keep the precision of their local coordinates.
+  Vector3 ToRelativePoint(const Vector3& localPoint, const Vector3& origin) const;
+
+  Matrix4 mLocalToWorld;
+  // The rotation and scale part of mLocalToWorld
+  Matrix3 mLinear;
+
+private:
+  void Build(const Vector3& scale, const Matrix3& rotation, const Vector3& translation);
+
+  Vector3 mScale;
+  Matrix3 mRotation;
+  Quaternion mQuaternion;
+  Vector3 mTranslation;
+  enum BuiltFrom { None, FromMatrix, FromQuaternion };
+  BuiltFrom mBuiltFrom;
+};
 
 //-----------------------------------------------------------------------------SupportShape
 class SupportShape
@@ -24,22 +61,52 @@ public:
   virtual Vector3 GetCenter() const = 0;
   virtual Vector3 Support(const Vector3& worldDirection) const = 0;
   virtual void DebugDraw(const Vector4& color = Vector4::cZero) const = 0;
+  // Fills out results[i] with the support point along worldDirections[i]. Shapes that can share work between
+  // directions override this, by default it's just one Support call per direction.
+  virtual void SupportBatch(const Vector3* worldDirections, size_t count, Vector3* results) const;
+  // Support(worldDirection) - origin. Shapes override this to subtract origin from their position before adding
+  // their extents, so shapes far from the world origin don't lose their detail (see RelativeOriginSupportShape).
+  virtual Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const;
+
+  // The tightest aabb around the shape (from the supports along each axis).
+  Aabb GetAabb() const;
 
   Vector3 GetCenter(const std::vector<Vector3>& localPoints, const Matrix4& localToWorldTransform) const;
   Vector3 Support(const Vector3& worldDirection, const std::vector<Vector3>& localPoints, const Matrix4& localToWorldTransform) const;
+  // Scans the local points with the direction moved into local space, only the winning point is transformed.
+  Vector3 Support(const Vector3& worldDirection, const std::vector<Vector3>& localPoints, const SupportTransform& transform) const;
+  // Index of the first local point furthest along the local direction, localPoints.size() if there are none.
+  static size_t MaxDotIndex(const std::vector<Vector3>& localPoints, const Vector3& localDirection);
   void DebugDraw(const std::vector<Vector3>& localPoints, const Matrix4& transform, const Vector4& color = Vector4::cZero) const;
+  // Draws the support points along the 26 directions of a 3x3x3 grid (for shapes with no vertices of their own).
+  void DebugDrawSupports(const Vector4& color = Vector4::cZero) const;
 };
 
 //-----------------------------------------------------------------------------ModelSupportShape
 class ModelSupportShape : public SupportShape
 {
 public:
+  ModelSupportShape();
 
   Vector3 GetCenter() const override;
+  // Hill-climbs the mesh's adjacency graph when it has one, otherwise scans every vertex.
   Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
   void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+  // Reads the model's transform once and keeps it, so queries stop checking the model for changes.
+  // For batches (see Gjk::Batch), which run every query while the models hold still.
+  void GatherTransform();
 
   Model* mModel;
+  // The vertex the last support query returned. Gjk's directions are coherent so climbing starts here.
+  mutable size_t mLastSupportVertex;
+
+private:
+  // Index of the mesh vertex furthest along the local direction (the vertex count if the mesh is empty).
+  size_t SupportVertex(const Vector3& localDirection) const;
+  const SupportTransform& GetTransform() const;
+  mutable SupportTransform mTransform;
+  bool mTransformGathered;
 };
 
 //-----------------------------------------------------------------------------PointsSupportShape
@@ -49,12 +116,17 @@ public:
   PointsSupportShape();
   Vector3 GetCenter() const override;
   Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
   void DebugDraw(const Vector4& color = Vector4::cZero) const override;
 
   std::vector<Vector3> mLocalSpacePoints;
   Vector3 mScale;
   Matrix3 mRotation;
   Vector3 mTranslation;
+
+private:
+  const SupportTransform& GetTransform() const;
+  mutable SupportTransform mTransform;
 };
 
 //-----------------------------------------------------------------------------SphereSupportShape
@@ -63,6 +135,7 @@ class SphereSupportShape : public SupportShape
 public:
   Vector3 GetCenter() const override;
   Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
   void DebugDraw(const Vector4& color = Vector4::cZero) const override;
 
   Sphere mSphere;
@@ -72,14 +145,154 @@ public:
 class ObbSupportShape : public SupportShape
 {
 public:
+  ObbSupportShape();
 
   Vector3 GetCenter() const override;
   Vector3 Support(const Vector3& worldDirection) const override;
+  void SupportBatch(const Vector3* worldDirections, size_t count, Vector3* results) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
   void DebugDraw(const Vector4& color = Vector4::cZero) const override;
 
   Vector3 mScale;
   Matrix3 mRotation;
   Vector3 mTranslation;
+
+private:
+  // Rebuilds the half axes when the scale or rotation they were built from change.
+  const Vector3* GetHalfAxes() const;
+
+  // Each local axis scaled by its half extent
+  mutable Vector3 mHalfAxes[3];
+  mutable Vector3 mBuiltScale;
+  mutable Matrix3 mBuiltRotation;
+  mutable bool mHalfAxesBuilt;
+};
+
+//-----------------------------------------------------------------------------CapsuleSupportShape
+// A segment of length 2 * mHalfHeight along the local y axis, grown by mRadius.
+class CapsuleSupportShape : public SupportShape
+{
+public:
+  CapsuleSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  Vector3 mTranslation;
+  Matrix3 mRotation;
+  float mHalfHeight;
+  float mRadius;
+};
+
+//-----------------------------------------------------------------------------CylinderSupportShape
+// A cylinder of height 2 * mHalfHeight along the local y axis.
+class CylinderSupportShape : public SupportShape
+{
+public:
+  CylinderSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  Vector3 mTranslation;
+  Matrix3 mRotation;
+  float mHalfHeight;
+  float mRadius;
+};
+
+//-----------------------------------------------------------------------------ConeSupportShape
+// A cone along the local y axis with its apex at +mHalfHeight and a base of mRadius at -mHalfHeight.
+class ConeSupportShape : public SupportShape
+{
+public:
+  ConeSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  Vector3 mTranslation;
+  Matrix3 mRotation;
+  float mHalfHeight;
+  float mRadius;
+};
+
+//-----------------------------------------------------------------------------MinkowskiSumSupportShape
+// Every point of A plus every point of B. An obb plus a sphere at the origin is a rounded box,
+// a segment (two points) plus a sphere is a capsule.
+class MinkowskiSumSupportShape : public SupportShape
+{
+public:
+  MinkowskiSumSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  const SupportShape* mShapeA;
+  const SupportShape* mShapeB;
+};
+
+//-----------------------------------------------------------------------------ConvexHullSupportShape
+// The convex hull of both shapes. The hull of one shape at two transforms is the volume it sweeps between them (ignoring
+// any rotation in between).
+class ConvexHullSupportShape : public SupportShape
+{
+public:
+  ConvexHullSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  const SupportShape* mShapeA;
+  const SupportShape* mShapeB;
+};
+
+//-----------------------------------------------------------------------------TransformedSupportShape
+// Another shape moved by a scale, rotation and translation. The wrapped shape only ever sees local directions.
+class TransformedSupportShape : public SupportShape
+{
+public:
+  TransformedSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  Vector3 RelativeSupport(const Vector3& worldDirection, const Vector3& origin) const override;
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  const SupportShape* mShape;
+  Vector3 mScale;
+  Matrix3 mRotation;
+  Vector3 mTranslation;
+
+private:
+  const SupportTransform& GetTransform() const;
+  mutable SupportTransform mTransform;
+};
+
+//-----------------------------------------------------------------------------RelativeOriginSupportShape
+// Another shape seen from a different origin, every point is the shape's point minus mOrigin. The CSO only depends on
+// differences of support points, so moving the origin between two shapes far from the world origin keeps Gjk's numbers small.
+class RelativeOriginSupportShape : public SupportShape
+{
+public:
+  RelativeOriginSupportShape();
+
+  Vector3 GetCenter() const override;
+  Vector3 Support(const Vector3& worldDirection) const override;
+  // Draws the wrapped shape where it really is
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override;
+
+  const SupportShape* mShape;
+  Vector3 mOrigin;
 };
 
 namespace VoronoiRegion
@@ -98,6 +311,37 @@ namespace VoronoiRegion
                                 "Unknown" };
 }
 
+//-----------------------------------------------------------------------------GjkStatistics
+// Counters a Gjk object keeps over the queries it runs (Intersect, the distance queries and the casts).
+// Every worker thread has its own Gjk so the counters are summed on the main thread instead of shared.
+struct GjkStatistics
+{
+  GjkStatistics();
+  void Clear();
+  void Add(const GjkStatistics& rhs);
+  // Writes one "Name value" line per counter so scripts can parse a frame's numbers.
+  void Dump(FILE* file) const;
+
+  size_t mCalls;
+  size_t mIterations;
+  // The most iterations any one query took
+  size_t mMaxIterations;
+  size_t mSupportCalls;
+  // Queries that stopped because a new support point made less than epsilon progress
+  size_t mEpsilonExits;
+  // Queries that used up maxIterations without converging
+  size_t mMaxIterationExits;
+  // Simplices too flat to solve directly plus warm start points dropped for being degenerate
+  size_t mDegenerateSimplices;
+  // Pairs a cached separating axis resolved without running a query (see GjkNarrowphase)
+  size_t mSeparatingAxisExits;
+
+  // How many queries took 1, 2, 3, 4, 5-8, 9-16, 17-32 and more than 32 iterations
+  static const size_t cIterationBuckets = 8;
+  static const char* cIterationBucketNames[cIterationBuckets];
+  size_t mIterationHistogram[cIterationBuckets];
+};
+
 /******Student:Assignment5******/
 // Implement gjk
 //-----------------------------------------------------------------------------Gjk
@@ -133,13 +377,297 @@ public:
     Vector3 mCsoPoint;
   };
 
+  // The simplex a query terminated with, stored as the search directions that produced each point.
+  // Directions (rather than points) are kept so the simplex can be rebuilt after the shapes move.
+  struct SimplexCache
+  {
+    SimplexCache();
+
+    size_t mSize;
+    Vector3 mDirections[4];
+    // The last direction the pair was found to be apart along (see SeparatedAlong). Only valid if mHasSeparatingAxis.
+    Vector3 mSeparatingAxis;
+    bool mHasSeparatingAxis;
+  };
+
+  // Penetration information for a pair of intersecting shapes (see Epa).
+  struct PenetrationInfo
+  {
+    // Contact normal pointing from A towards B. Moving B by mNormal * mDepth separates the shapes.
+    Vector3 mNormal;
+    float mDepth;
+    // The deepest points on each object.
+    Vector3 mPointA;
+    Vector3 mPointB;
+  };
+
+  // How a shape moves over time (see TimeOfImpact). The shape spins about its starting center while it translates.
+  struct Motion
+  {
+    Motion();
+
+    Vector3 mLinearVelocity;
+    // Axis times angular speed (radians per unit of time)
+    Vector3 mAngularVelocity;
+  };
+
+  // Where and when two moving shapes first touch (see TimeOfImpact).
+  struct ImpactInfo
+  {
+    float mTime;
+    // Points from A towards B (zero if the shapes already overlap at time 0).
+    Vector3 mNormal;
+    // The closest points on each object at mTime.
+    Vector3 mPointA;
+    Vector3 mPointB;
+  };
+
+  // The compact result of one pair from IntersectBatch.
+  struct BatchResult
+  {
+    bool mIntersecting;
+    // False when the pair's cached separating axis still separated it. Gjk was skipped then, so the rest isn't filled out.
+    bool mHasClosestPoint;
+    // 0 when the shapes intersect (only an upper bound if the query ran out of iterations)
+    float mDistance;
+    // The closest points on each object (only meaningful when not intersecting)
+    Vector3 mPointA;
+    Vector3 mPointB;
+  };
+
+  // The simplex one pair of IntersectBatch terminated with (what Epa expects when the pair is intersecting).
+  // Empty when the pair's cached separating axis resolved it.
+  struct BatchSimplex
+  {
+    CsoPoint mPoints[4];
+    size_t mSize;
+  };
+
+  // Broadphase pairs of Models ready for IntersectBatch. Every model shows up once with its transform gathered once,
+  // and the pairs are sorted by their meshes' types so consecutive queries walk the same kind of vertex data.
+  struct Batch
+  {
+    struct Pair
+    {
+      bool operator<(const Pair& rhs) const;
+
+      int mTypes[2];
+      // Indices into mShapes
+      unsigned int mShapes[2];
+      // The pair's index in the QueryResults the batch was built from, which is also where its results go
+      size_t mPairIndex;
+      SimplexCache* mCache;
+    };
+
+    // Fills out the batch from the pairs, looking each pair up in the cache when one is given (on the calling
+    // thread, since the cache's map can't be modified by several threads). The models must not move until the batch has run.
+    void Build(const QueryResults& pairs, GjkPairCache* cache = nullptr);
+
+    std::vector<Model*> mModels;
+    std::vector<ModelSupportShape> mShapes;
+    std::vector<Pair> mPairs;
+  };
+
+  // All of a query's scratch state lives on the Gjk object, so one object can only run one query at a
+  // time. Separate objects (e.g. one per thread) can run concurrently as long as their shapes aren't shared.
   Gjk();
 
   // Returns true if the shapes intersect. If the shapes don't intersect then closestPoint is filled out with the closest points
   // on each object as well as the cso point. Epsilon should be used for checking if sufficient progress has been made at any step.
   // The debugging values are for your own use (make sure they don't interfere with the unit tests).
-  bool Intersect(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon, int debuggingIndex, bool debugDraw);
+  // If a cache is given the query starts from the cached simplex (when it has one) and the terminating simplex is written back to it.
+  // Running out of maxIterations also returns false, with closestPoint being the closest point found so far (its distance is
+  // only an upper bound and the direction to it may not separate the shapes).
+  // When both shapes are exactly one of the support shapes above this dispatches to the matching Intersect<ShapeA, ShapeB>.
+  bool Intersect(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon, int debuggingIndex, bool debugDraw,
+    SimplexCache* cache = nullptr);
+  // Same as above for shapes whose types are known at the call site. The concrete Support functions are called directly
+  // (so they can be inlined) instead of through the vtable. Instantiated for every pair of the support shapes above
+  // and SupportShape itself, which keeps the virtual calls (e.g. for shapes deriving from the ones above).
+  template <typename ShapeA, typename ShapeB>
+  bool Intersect(const ShapeA* shapeA, const ShapeB* shapeB, unsigned int maxIterations, CsoPoint& closestPoint, float epsilon,
+    SimplexCache* cache = nullptr);
+  // Same as Intersect but both shapes are re-centered on the midpoint between their centers first (see
+  // RelativeOriginSupportShape). For pairs far from the world origin, where the CSO points lose the precision Gjk needs
+  // to converge. The closest point and mSimplex are moved back to world space.
+  bool IntersectRelative(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, CsoPoint& closestPoint,
+    float epsilon, SimplexCache* cache = nullptr);
+
+  // Returns the distance between the shapes (0 if they intersect). closestPoint is filled out with the closest points on each object.
+  float Distance(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+    CsoPoint& closestPoint, SimplexCache* cache = nullptr);
+  // Returns true if the shapes are no further than maxDistance apart (distance and closestPoint are then exact to epsilon).
+  // Stops as soon as the lower bound on the distance passes maxDistance, so far apart pairs only take an iteration or two.
+  bool DistanceWithin(const SupportShape* shapeA, const SupportShape* shapeB, float maxDistance, unsigned int maxIterations, float epsilon,
+    float& distance, CsoPoint& closestPoint, SimplexCache* cache = nullptr);
+  // Returns true as soon as an axis separating the shapes is found (separatingAxis then points from A towards B).
+  // Returns false if the shapes intersect or no axis was found in maxIterations.
+  bool Separated(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+    Vector3& separatingAxis, SimplexCache* cache = nullptr);
+
+  // Conservative advancement. Returns true if the moving shapes come within tolerance of each other in [0, maxTime], with
+  // info.mTime being the first such time. Each step moves the shapes forward by a lower bound on their distance over an upper bound
+  // on how fast they can close it (so they never pass through each other) and warm starts the next distance query from the last.
+  // maxSteps limits the advancement steps and maxIterations each step's distance query. A step whose query can't bound the distance
+  // away from zero (it didn't converge or the shapes nearly touch) is reported as an impact at that step's time, not a miss.
+  // Returns false if the shapes separate, don't reach each other by maxTime or maxSteps steps weren't enough.
+  bool TimeOfImpact(const SupportShape* shapeA, const Motion& motionA, const SupportShape* shapeB, const Motion& motionB,
+    float maxTime, float tolerance, unsigned int maxSteps, unsigned int maxIterations, float epsilon, ImpactInfo& info);
+
+  // Gjk ray cast (van den Bergen). Returns true if the ray hits the shape with t in [0, maxT], filling out t and the surface normal
+  // at the hit. The ray's point is moved up to the shape while the simplex closes in on it, so a hit only takes a few support calls.
+  // A ray starting inside the shape hits at t = 0 with a zero normal. Returns false if maxIterations run out before the ray's point
+  // reaches the shape (a miss can't be told apart from a slow hit then).
+  bool RayCast(const SupportShape* shape, const Ray& ray, float maxT, unsigned int maxIterations, float epsilon, float& t, Vector3& normal);
+
+  // Linear cast. Moves shapeA along the sweep and returns true if it hits shapeB on the way, with t being the fraction of the sweep
+  // travelled and normal pointing from B towards A at the hit. Runs as a ray cast from the origin against the cso (B - A).
+  bool ShapeCast(const SupportShape* shapeA, const Vector3& sweep, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+    float& t, Vector3& normal);
+
+  // Runs the batch's sorted pairs [begin, end) through Intersect<ModelSupportShape, ModelSupportShape>, filling out
+  // results[pair.mPairIndex] (and simplices[pair.mPairIndex] if given). A pair with a cache first tries the cache's separating
+  // axis and skips Gjk if it still separates, otherwise the cache warm starts the query and gets the new axis. Ranges of one
+  // batch can run on separate Gjk objects at the same time. With relativeOrigin every pair goes through IntersectRelative.
+  void IntersectBatch(const Batch& batch, size_t begin, size_t end, unsigned int maxIterations, float epsilon, bool relativeOrigin,
+    BatchResult* results, BatchSimplex* simplices = nullptr);
+  // Builds a batch from the pairs and runs all of it on this object, results[i] is filled out for pairs.mResults[i].
+  void IntersectBatch(const QueryResults& pairs, unsigned int maxIterations, float epsilon, std::vector<BatchResult>& results,
+    GjkPairCache* cache = nullptr);
+
   // Finds the point furthest in the given direction on the CSO (and the relevant points from each object)
   CsoPoint ComputeSupport(const SupportShape* shapeA, const SupportShape* shapeB, const Vector3& direction);
+  // Returns true if the CSO's support point along the direction is behind the origin, which proves the shapes don't
+  // intersect. Costs one support call per shape so it's worth trying a previous frame's axis before running Intersect.
+  bool SeparatedAlong(const SupportShape* shapeA, const SupportShape* shapeB, const Vector3& direction, CsoPoint& supportPoint);
+
+  // Expanding polytope algorithm. Given the simplex Intersect terminated with (which must enclose the origin)
+  // this grows it towards the CSO boundary to find the penetration depth, normal and deepest points.
+  // Returns false if no polytope could be built from the simplex (e.g. the shapes are only touching).
+  bool Epa(const SupportShape* shapeA, const SupportShape* shapeB, const CsoPoint simplex[4], size_t simplexSize,
+    unsigned int maxIterations, float epsilon, PenetrationInfo& info);
+
+  // The simplex the last call to Intersect terminated with. When Intersect returns true this is what Epa expects.
+  CsoPoint mSimplex[4];
+  size_t mSimplexSize;
+  // Accumulates over every query until cleared
+  GjkStatistics mStatistics;
+
+private:
+  //---------------------------------------------------------------------------EpaPolytope
+  // Fixed size buffers for the polytope so Epa never allocates. The expansion stops early (keeping the
+  // polytope closed and returning its closest face) when the next step wouldn't fit in these.
+  struct EpaFace
+  {
+    size_t mIndices[3];
+    Vector3 mNormal;
+    float mDistance;
+  };
+
+  struct EpaEdge
+  {
+    size_t mIndices[2];
+  };
+
+  struct EpaPolytope
+  {
+    static const size_t cMaxVertices = 64;
+    static const size_t cMaxFaces = 128;
+    static const size_t cMaxEdges = 64;
+
+    // Returns false if the face buffer is full. Degenerate faces are dropped.
+    bool AddFace(size_t i0, size_t i1, size_t i2);
+    // Adds an edge on the horizon of the removed faces. An edge shared by two removed faces cancels out.
+    // Returns false if the edge buffer is full.
+    bool AddHorizonEdge(size_t i0, size_t i1);
+    bool IsVisible(const EpaFace& face, const Vector3& point) const;
+    size_t ClosestFace() const;
+
+    CsoPoint mVertices[cMaxVertices];
+    EpaFace mFaces[cMaxFaces];
+    EpaEdge mEdges[cMaxEdges];
+    size_t mVertexCount;
+    size_t mFaceCount;
+    size_t mEdgeCount;
+  };
+
+  // Grows the polytope's starting simplex to a non-degenerate tetrahedron.
+  bool BuildTetrahedron(const SupportShape* shapeA, const SupportShape* shapeB);
+
+  EpaPolytope mPolytope;
+
+  // Reduces the simplex to the sub-simplex closest to the origin (signed volumes solver), filling out the closest cso point
+  // (and the matching points on each object) and the direction to search next. Returns true if the simplex was degenerate.
+  bool ReduceSimplex(CsoPoint simplex[4], Vector3 directions[4], size_t& size, CsoPoint& closestPoint, Vector3& searchDirection);
+  // Shared loop of the distance queries. Stops when the distance converges, when the lower bound passes maxDistance or, if
+  // stopOnSeparatingAxis is set, at the first separating axis. Returns the upper bound on the distance (0 if intersecting).
+  float DistanceQuery(const SupportShape* shapeA, const SupportShape* shapeB, unsigned int maxIterations, float epsilon,
+    float maxDistance, bool stopOnSeparatingAxis, CsoPoint& closestPoint, Vector3& separatingAxis, float& lowerBound, SimplexCache* cache);
+
+  // Rebuilds the cached simplex against the current shapes, dropping points that would make it degenerate. Returns the new size.
+  template <typename ShapeA, typename ShapeB>
+  size_t WarmStart(const ShapeA* shapeA, const ShapeB* shapeB, const SimplexCache& cache, CsoPoint simplex[4], Vector3 directions[4]);
+  // Counts a finished query in mStatistics.
+  void RecordQuery(size_t iterations, bool epsilonExit, bool maxIterationExit);
+  // Records the terminating simplex on this object (for Epa) and in the cache if there is one.
+  void StoreSimplex(SimplexCache* cache, const CsoPoint simplex[4], const Vector3 directions[4], size_t size);
+
+  // Scratch for the QueryResults overload of IntersectBatch, kept between calls so a batch doesn't allocate once it has grown.
+  Batch mBatch;
+};
+
+// Linear casts of a shape against a spatial partition's bounding volumes (see SpatialPartition::CastShape).
+// A query runs one of these per candidate volume, so the caller passes in one Gjk to reuse for all of them.
+bool ShapeCastAabb(Gjk& gjk, const SupportShape& shape, const Vector3& sweep, const Aabb& aabb, float& t);
+bool ShapeCastSphere(Gjk& gjk, const SupportShape& shape, const Vector3& sweep, const Sphere& sphere, float& t);
+
+//-----------------------------------------------------------------------------GjkPairCache
+// Per-pair simplex caches that persist between frames so Gjk can warm start coherent pairs.
+// Pairs are keyed by the QueryResult from the broadphase (the two models' client data).
+class GjkPairCache
+{
+public:
+  // Returns the cache for the given pair (creating an empty one if needed) and marks it as used this frame.
+  Gjk::SimplexCache& Find(const QueryResult& pair);
+  // Removes every pair that wasn't looked up since the last prune (no longer overlapping or destroyed).
+  void Prune();
+  void Clear();
+
+  struct Entry
+  {
+    Gjk::SimplexCache mCache;
+    bool mUsed;
+  };
+  typedef std::map<QueryResult, Entry> PairMap;
+  PairMap mPairs;
+};
+
+//-----------------------------------------------------------------------------GjkNarrowphase
+// Runs Gjk over every pair of Models from the broadphase, split across a worker pool. The pairs are built into one
+// Gjk::Batch and each worker runs its chunks of it with its own Gjk (see Gjk::IntersectBatch).
+class GjkNarrowphase
+{
+public:
+  GjkNarrowphase();
+
+  // Fills out mResults and mSimplices with one entry per pair (in the same order). Every pair is looked up in the
+  // cache up front so the workers only ever touch their own pair's simplex. Pairs still apart along the
+  // separating axis cached from their last query are resolved with two support calls instead of Gjk.
+  void Intersect(const QueryResults& pairs, GjkPairCache& cache, unsigned int maxIterations, float epsilon);
+  // The narrowphase's threads, for other batch work that runs outside of Intersect (like building the broadphase)
+  WorkerPool& GetWorkerPool();
+
+  std::vector<Gjk::BatchResult> mResults;
+  std::vector<Gjk::BatchSimplex> mSimplices;
+  // Every worker's counters from the last call to Intersect summed together
+  GjkStatistics mStatistics;
+  // The number of pairs each worker grabs at a time
+  size_t mChunkSize;
+  // Runs every pair through Gjk::IntersectRelative (for worlds much larger than the objects in them)
+  bool mRelativeOrigin;
 
+private:
+  WorkerPool mPool;
+  std::vector<Gjk> mSolvers;
+  Gjk::Batch mBatch;
 };
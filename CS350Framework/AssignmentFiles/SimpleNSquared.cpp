@@ -77,6 +77,17 @@ void NSquaredSpatialPartition::CastFrustum(const Frustum& frustum, CastResults&
   }
 }
 
+void NSquaredSpatialPartition::CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results)
+{
+  // Add everything
+  for (size_t i = 0; i < mData.size(); ++i)
+  {
+    CastResult result;
+    result.mClientData = mData[i];
+    results.AddResult(result);
+  }
+}
+
 void NSquaredSpatialPartition::SelfQuery(QueryResults& results)
 {
   // Add everything
@@ -180,6 +191,22 @@ void BoundingSphereSpatialPartition::CastFrustum(const Frustum& frustum, CastRes
   }
 }
 
+void BoundingSphereSpatialPartition::CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results)
+{
+  Gjk gjk;
+  for (size_t i = 0; i < mData.size(); ++i)
+  {
+    float t = 0.0f;
+    if (ShapeCastSphere(gjk, shape, sweep, mSpheres[i], t))
+    {
+      CastResult result;
+      result.mTime = t;
+      result.mClientData = mData[i];
+      results.AddResult(result);
+    }
+  }
+}
+
 void BoundingSphereSpatialPartition::SelfQuery(QueryResults& results)
 {
   for (size_t i = 0; i < mData.size(); ++i)
@@ -28,6 +28,7 @@ public:
 
   void CastRay(const Ray& ray, CastResults& results) override;
   void CastFrustum(const Frustum& frustum, CastResults& results) override;
+  void CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results) override;
 
   void SelfQuery(QueryResults& results) override;
 
@@ -53,6 +54,7 @@ public:
 
   void CastRay(const Ray& ray, CastResults& results) override;
   void CastFrustum(const Frustum& frustum, CastResults& results) override;
+  void CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results) override;
 
   void SelfQuery(QueryResults& results) override;
 
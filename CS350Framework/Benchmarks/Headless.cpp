@@ -0,0 +1,140 @@
+#include "Precompiled.hpp"
+
+// What the benchmarked sources need from Application.cpp and DebugDraw.cpp, minus the
+// window. Debug drawing is dropped: every Draw call hands back the same scratch shape.
+
+//-----------------------------------------------------------------------------Statistics
+Statistics Application::mStatistics = Statistics();
+
+Statistics::Statistics()
+{
+  mFps = 1 / 60.0f;
+  Clear();
+}
+
+void Statistics::Clear()
+{
+  mAabbAabbTests = 0;
+  mRayAabbTests = 0;
+  mSphereSphereTests = 0;
+  mRaySphereTests = 0;
+  mPlaneSphereTests = 0;
+  mPlaneAabbTests = 0;
+  mSelfCollisionsCount = 0;
+
+  mRayPlaneTests = 0;
+  mRayTriangleTests = 0;
+  mPlaneTriangleTests = 0;
+  mFrustumTriangleTests = 0;
+  mFrustumSphereTests = 0;
+  mFrustumAabbTests = 0;
+
+  mGjk.Clear();
+}
+
+//-----------------------------------------------------------------------------DebugShape
+DebugShape::DebugShape()
+{
+  mColor = Vector4(.6f);
+  mMask = (unsigned int)-1;
+  mTimer = 0;
+  mOnTop = false;
+  mTransform.SetIdentity();
+}
+
+DebugShape& DebugShape::Color(const Vector4& color)
+{
+  return *this;
+}
+
+DebugShape& DebugShape::OnTop(bool state)
+{
+  return *this;
+}
+
+DebugShape& DebugShape::Time(float time)
+{
+  return *this;
+}
+
+DebugShape& DebugShape::SetMaskBit(int bitIndex)
+{
+  return *this;
+}
+
+DebugShape& DebugShape::SetTransform(const Matrix4& transform)
+{
+  return *this;
+}
+
+//-----------------------------------------------------------------------------DebugDrawer
+DebugDrawer* gDebugDrawer = new DebugDrawer();
+
+DebugDrawer::DebugDrawer()
+{
+  mActiveMask = (unsigned int)-1;
+  mApplication = NULL;
+  mShapes.push_back(DebugShape());
+}
+
+void DebugDrawer::Update(float dt)
+{
+}
+
+void DebugDrawer::Draw()
+{
+}
+
+DebugShape& DebugDrawer::GetNewShape()
+{
+  return mShapes.back();
+}
+
+void DebugDrawer::DrawDisc(DebugShape& shape, const Plane& plane, const Vector3& point, float radius)
+{
+}
+
+DebugShape& DebugDrawer::DrawPoint(const Vector3& point)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawLine(const LineSegment& line)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawRay(const Ray& ray, float t)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawSphere(const Sphere& sphere)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawAabb(const Aabb& aabb)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawTriangle(const Triangle& triangle)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawPlane(const Plane& plane, float sizeX, float sizeY)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawQuad(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3)
+{
+  return GetNewShape();
+}
+
+DebugShape& DebugDrawer::DrawFrustum(const Frustum& frustum)
+{
+  return GetNewShape();
+}
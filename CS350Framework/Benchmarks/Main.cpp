@@ -0,0 +1,19 @@
+#include "Precompiled.hpp"
+
+//-----------------------------------------------------------------------------
+// Runs the gjk benchmarks without a window ("Benchmarks [outFile]"). Without an
+// output file the report goes to stdout.
+int main(int argc, char *argv[])
+{
+  FILE* file = stdout;
+  if(argc >= 2 && argv[1] != NULL)
+    fopen_s(&file, argv[1], "w");
+  if(file == NULL)
+    return 1;
+
+  RunGjkBenchmarks(file);
+
+  if(file != stdout)
+    fclose(file);
+  return 0;
+}
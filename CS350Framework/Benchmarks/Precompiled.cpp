@@ -0,0 +1,4 @@
+///////////////////////////////////////////////////////////////////////////////
+///	Copyright 2016, DigiPen Institute of Technology
+///////////////////////////////////////////////////////////////////////////////
+#include "Precompiled.hpp"
@@ -0,0 +1,32 @@
+///////////////////////////////////////////////////////////////////////////////
+///	Copyright 2016, DigiPen Institute of Technology
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// The headless benchmark's precompiled header. Same framework headers as the
+// application's but without SDL, OpenGL or AntTweakBar.
+#include "Math/Precompiled.hpp"
+
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// The framework headers only name AntTweakBar's types in declarations (property panels and
+// the application's bars). Nothing in this project defines or calls those so stand-ins do.
+typedef struct CTwBar TwBar;
+typedef int TwType;
+
+#include "Application.hpp"
+#include "Components.hpp"
+#include "DebugDraw.hpp"
+#include "Geometry.hpp"
+#include "Gjk.hpp"
+#include "GjkBenchmarks.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "Shapes.hpp"
+#include "SpatialPartition.hpp"
+#include "WorkerPool.hpp"
@@ -0,0 +1,441 @@
+#include "Precompiled.hpp"
+#include "Components.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "GjkBenchmarks.hpp"
+#include "Gjk.hpp"
+
+#include <chrono>
+
+// Headless timings of Gjk::Intersect and Gjk::ComputeSupport over canonical shape pairs. Nothing here
+// touches SDL, OpenGL or AntTweakBar so it runs from the command line, either through CheckForBenchmarks in Main.cpp
+// or from the Benchmarks project which builds only the gjk, shape and mesh sources. That project defines
+// GJK_BENCHMARKS_HEADLESS and leaves the Model cases out as models need the application's components. The Mesh
+// cases time the same hill-climbing and simd vertex scans the models use, straight off the mesh, so both builds cover them.
+// Every line of the report is "kind key=value ..." so runs can be diffed or parsed by scripts.
+
+// Poses timed per case (each query gets its own pose so the branch predictors can't learn one)
+static const size_t cBenchmarkPoses = 2048;
+// Direction batches timed per ComputeSupport case, and the directions in each batch
+static const size_t cSupportSamples = 64;
+static const size_t cSupportBatch = 64;
+static const float cBenchmarkEpsilon = 0.001f;
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static double ElapsedNs(const BenchmarkClock::time_point& start, const BenchmarkClock::time_point& end)
+{
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Small deterministic generator so every run times the same poses
+class BenchmarkRandom
+{
+public:
+  BenchmarkRandom(unsigned int seed) : mState(seed) {}
+
+  float Float(float min, float max)
+  {
+    mState = mState * 1664525u + 1013904223u;
+    return min + (max - min) * ((mState >> 8) / (float)(1 << 24));
+  }
+
+  Vector3 Direction()
+  {
+    // Rejection sample the unit ball so the directions are uniform
+    for (;;)
+    {
+      Vector3 v(Float(-1, 1), Float(-1, 1), Float(-1, 1));
+      float lengthSq = v.LengthSq();
+      if (lengthSq > 0.0001f && lengthSq <= 1.0f)
+      {
+        return v / Math::Sqrt(lengthSq);
+      }
+    }
+  }
+
+  Matrix3 Rotation()
+  {
+    return Math::ToMatrix3(Direction(), Float(0.0f, Math::cTwoPi));
+  }
+
+private:
+  unsigned int mState;
+};
+
+// The value below which the given fraction of the sorted values fall
+static double Percentile(const std::vector<double>& sortedValues, double fraction)
+{
+  size_t index = (size_t)(fraction * sortedValues.size());
+  return sortedValues[Math::Min(index, sortedValues.size() - 1)];
+}
+
+static double Mean(const std::vector<double>& values)
+{
+  double sum = 0.0;
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    sum += values[i];
+  }
+  return sum / values.size();
+}
+
+// A convex uv-sphere of radius 1 with rings * segments + 2 vertices
+static void BuildSphereMesh(size_t rings, size_t segments, Mesh& mesh)
+{
+  mesh.mVertices.clear();
+  mesh.mIndices.clear();
+
+  mesh.mVertices.push_back(Vector3(0, 1, 0));
+  for (size_t r = 0; r < rings; ++r)
+  {
+    float polar = Math::cPi * (r + 1) / (rings + 1);
+    for (size_t s = 0; s < segments; ++s)
+    {
+      float azimuth = Math::cTwoPi * s / segments;
+      mesh.mVertices.push_back(Vector3(Math::Sin(polar) * Math::Cos(azimuth), Math::Cos(polar), Math::Sin(polar) * Math::Sin(azimuth)));
+    }
+  }
+  mesh.mVertices.push_back(Vector3(0, -1, 0));
+
+  size_t bottom = mesh.mVertices.size() - 1;
+  for (size_t s = 0; s < segments; ++s)
+  {
+    size_t next = (s + 1) % segments;
+    mesh.mIndices.push_back(0);
+    mesh.mIndices.push_back(1 + next);
+    mesh.mIndices.push_back(1 + s);
+
+    for (size_t r = 0; r + 1 < rings; ++r)
+    {
+      size_t v0 = 1 + r * segments + s;
+      size_t v1 = 1 + r * segments + next;
+      size_t v2 = v0 + segments;
+      size_t v3 = v1 + segments;
+      mesh.mIndices.push_back(v0);
+      mesh.mIndices.push_back(v1);
+      mesh.mIndices.push_back(v3);
+      mesh.mIndices.push_back(v0);
+      mesh.mIndices.push_back(v3);
+      mesh.mIndices.push_back(v2);
+    }
+
+    mesh.mIndices.push_back(bottom);
+    mesh.mIndices.push_back(1 + (rings - 1) * segments + s);
+    mesh.mIndices.push_back(1 + (rings - 1) * segments + next);
+  }
+
+  mesh.BuildAdjacency();
+  mesh.BuildSoaVertices();
+}
+
+//-----------------------------------------------------------------------------BenchmarkShape
+// One side of a benchmark pair. Every kind roughly fits the unit sphere so distances mean the same thing for all of them.
+class BenchmarkShape
+{
+public:
+  virtual ~BenchmarkShape() {}
+  virtual const SupportShape* GetShape() const = 0;
+  virtual void SetPose(const Vector3& translation, const Matrix3& rotation) = 0;
+  virtual const char* GetName() const = 0;
+  virtual size_t GetVertexCount() const { return 0; }
+};
+
+class SphereBenchmarkShape : public BenchmarkShape
+{
+public:
+  SphereBenchmarkShape()
+  {
+    mShape.mSphere = Sphere(Vector3::cZero, 1.0f);
+  }
+
+  const SupportShape* GetShape() const override { return &mShape; }
+  void SetPose(const Vector3& translation, const Matrix3& rotation) override
+  {
+    mShape.mSphere.mCenter = translation;
+  }
+  const char* GetName() const override { return "Sphere"; }
+
+  SphereSupportShape mShape;
+};
+
+class ObbBenchmarkShape : public BenchmarkShape
+{
+public:
+  ObbBenchmarkShape()
+  {
+    mShape.mScale = Vector3(1.4f, 1.0f, 0.6f);
+  }
+
+  const SupportShape* GetShape() const override { return &mShape; }
+  void SetPose(const Vector3& translation, const Matrix3& rotation) override
+  {
+    mShape.mTranslation = translation;
+    mShape.mRotation = rotation;
+  }
+  const char* GetName() const override { return "Obb"; }
+
+  ObbSupportShape mShape;
+};
+
+// The sphere mesh's vertices without any adjacency, so every support scans all of them
+class PointsBenchmarkShape : public BenchmarkShape
+{
+public:
+  PointsBenchmarkShape(const Mesh& mesh)
+  {
+    mShape.mLocalSpacePoints = mesh.mVertices;
+  }
+
+  const SupportShape* GetShape() const override { return &mShape; }
+  void SetPose(const Vector3& translation, const Matrix3& rotation) override
+  {
+    mShape.mTranslation = translation;
+    mShape.mRotation = rotation;
+  }
+  const char* GetName() const override { return "Points"; }
+  size_t GetVertexCount() const override { return mShape.mLocalSpacePoints.size(); }
+
+  PointsSupportShape mShape;
+};
+
+// Supports a mesh the way ModelSupportShape does, but posed directly instead of through a model's transform.
+// Climbing needs the mesh's adjacency and scanning its simd vertices, the one asked for must be built.
+class MeshSupportShape : public SupportShape
+{
+public:
+  MeshSupportShape(const Mesh* mesh, bool hillClimb)
+  {
+    mMesh = mesh;
+    mHillClimb = hillClimb;
+    mLastSupportVertex = 0;
+    mTransform.Update(Vector3(1), Matrix3::cIdentity, Vector3::cZero);
+  }
+
+  Vector3 GetCenter() const override
+  {
+    return SupportShape::GetCenter(mMesh->mVertices, mTransform.mLocalToWorld);
+  }
+
+  Vector3 Support(const Vector3& worldDirection) const override
+  {
+    Vector3 localDirection = mTransform.ToLocalDirection(worldDirection);
+    size_t vertex;
+    if (mHillClimb)
+    {
+      mLastSupportVertex = mMesh->HillClimb(localDirection, mLastSupportVertex);
+      vertex = mLastSupportVertex;
+    }
+    else
+    {
+      vertex = mMesh->MaxDotVertex(localDirection);
+    }
+    return mTransform.ToWorldPoint(mMesh->mVertices[vertex]);
+  }
+
+  void DebugDraw(const Vector4& color = Vector4::cZero) const override
+  {
+  }
+
+  const Mesh* mMesh;
+  bool mHillClimb;
+  mutable size_t mLastSupportVertex;
+  SupportTransform mTransform;
+};
+
+class MeshBenchmarkShape : public BenchmarkShape
+{
+public:
+  MeshBenchmarkShape(const Mesh& mesh, bool hillClimb) : mShape(&mesh, hillClimb)
+  {
+  }
+
+  const SupportShape* GetShape() const override { return &mShape; }
+  void SetPose(const Vector3& translation, const Matrix3& rotation) override
+  {
+    mShape.mTransform.Update(Vector3(1), rotation, translation);
+  }
+  const char* GetName() const override { return mShape.mHillClimb ? "MeshClimb" : "MeshSimd"; }
+  size_t GetVertexCount() const override { return mShape.mMesh->mVertices.size(); }
+
+  MeshSupportShape mShape;
+};
+
+#ifndef GJK_BENCHMARKS_HEADLESS
+// A model on a game object without an application, supported by hill-climbing the sphere mesh
+class ModelBenchmarkShape : public BenchmarkShape
+{
+public:
+  ModelBenchmarkShape(Mesh* mesh) : mObject(nullptr)
+  {
+    Transform* transform = new Transform();
+    Model* model = new Model();
+    model->mMesh = mesh;
+    mObject.Add(transform);
+    mObject.Add(model);
+    mShape.mModel = model;
+    mShape.GatherTransform();
+  }
+
+  const SupportShape* GetShape() const override { return &mShape; }
+  void SetPose(const Vector3& translation, const Matrix3& rotation) override
+  {
+    Transform* transform = mObject.has(Transform);
+    transform->mTranslation = translation;
+    transform->mRotation = Math::ToQuaternion(rotation);
+    mShape.GatherTransform();
+  }
+  const char* GetName() const override { return "Model"; }
+  size_t GetVertexCount() const override { return mShape.mModel->mMesh->mVertices.size(); }
+
+  GameObject mObject;
+  ModelSupportShape mShape;
+};
+#endif
+
+//-----------------------------------------------------------------------------Benchmark cases
+// Shape A sits at the origin, shape B's center is centerDistance away in a random direction and
+// both get a random rotation for each pose. The pose is set outside of the timed region.
+static void BenchmarkIntersect(BenchmarkShape& shapeA, BenchmarkShape& shapeB, float centerDistance, unsigned int maxIterations, FILE* file)
+{
+  BenchmarkRandom random(1234);
+  std::vector<Vector3> translations(cBenchmarkPoses);
+  std::vector<Matrix3> rotationsA(cBenchmarkPoses);
+  std::vector<Matrix3> rotationsB(cBenchmarkPoses);
+  for (size_t i = 0; i < cBenchmarkPoses; ++i)
+  {
+    translations[i] = random.Direction() * centerDistance;
+    rotationsA[i] = random.Rotation();
+    rotationsB[i] = random.Rotation();
+  }
+
+  Gjk gjk;
+  std::vector<double> times(cBenchmarkPoses);
+  std::vector<double> iterations(cBenchmarkPoses);
+  size_t hits = 0;
+
+  // The first pass only warms the caches and the shapes' cached transforms up
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    hits = 0;
+    for (size_t i = 0; i < cBenchmarkPoses; ++i)
+    {
+      shapeA.SetPose(Vector3::cZero, rotationsA[i]);
+      shapeB.SetPose(translations[i], rotationsB[i]);
+
+      Gjk::CsoPoint closestPoint;
+      size_t iterationsBefore = gjk.mStatistics.mIterations;
+      BenchmarkClock::time_point start = BenchmarkClock::now();
+      bool intersecting = gjk.Intersect(shapeA.GetShape(), shapeB.GetShape(), maxIterations, closestPoint, cBenchmarkEpsilon, -1, false);
+      BenchmarkClock::time_point end = BenchmarkClock::now();
+
+      hits += intersecting ? 1 : 0;
+      times[i] = ElapsedNs(start, end);
+      iterations[i] = (double)(gjk.mStatistics.mIterations - iterationsBefore);
+    }
+  }
+
+  double timeMean = Mean(times);
+  double iterationMean = Mean(iterations);
+  std::sort(times.begin(), times.end());
+  std::sort(iterations.begin(), iterations.end());
+
+  fprintf(file, "intersect pair=%s-%s verticesA=%zu verticesB=%zu distance=%.2f maxIterations=%u hits=%zu "
+    "nsMean=%.1f nsP50=%.1f nsP90=%.1f nsP99=%.1f iterationsMean=%.2f iterationsP50=%.0f iterationsP99=%.0f iterationsMax=%.0f\n",
+    shapeA.GetName(), shapeB.GetName(), shapeA.GetVertexCount(), shapeB.GetVertexCount(), centerDistance, maxIterations, hits,
+    timeMean, Percentile(times, 0.5), Percentile(times, 0.9), Percentile(times, 0.99),
+    iterationMean, Percentile(iterations, 0.5), Percentile(iterations, 0.99), iterations.back());
+}
+
+// Single support calls are too short for the clock so batches of them are timed and divided out
+static void BenchmarkComputeSupport(BenchmarkShape& shapeA, BenchmarkShape& shapeB, FILE* file)
+{
+  BenchmarkRandom random(5678);
+  shapeA.SetPose(Vector3::cZero, random.Rotation());
+  shapeB.SetPose(random.Direction() * 1.5f, random.Rotation());
+
+  std::vector<Vector3> directions(cSupportSamples * cSupportBatch);
+  for (size_t i = 0; i < directions.size(); ++i)
+  {
+    directions[i] = random.Direction();
+  }
+
+  Gjk gjk;
+  std::vector<double> times(cSupportSamples);
+  // Summed so the calls can't be optimized out
+  Vector3 sum = Vector3::cZero;
+  for (size_t pass = 0; pass < 2; ++pass)
+  {
+    for (size_t i = 0; i < cSupportSamples; ++i)
+    {
+      const Vector3* batch = &directions[i * cSupportBatch];
+      BenchmarkClock::time_point start = BenchmarkClock::now();
+      for (size_t j = 0; j < cSupportBatch; ++j)
+      {
+        sum += gjk.ComputeSupport(shapeA.GetShape(), shapeB.GetShape(), batch[j]).mCsoPoint;
+      }
+      BenchmarkClock::time_point end = BenchmarkClock::now();
+      times[i] = ElapsedNs(start, end) / cSupportBatch;
+    }
+  }
+
+  double timeMean = Mean(times);
+  std::sort(times.begin(), times.end());
+  fprintf(file, "support pair=%s-%s verticesA=%zu verticesB=%zu nsMean=%.1f nsP50=%.1f nsP90=%.1f nsP99=%.1f checksum=%.3f\n",
+    shapeA.GetName(), shapeB.GetName(), shapeA.GetVertexCount(), shapeB.GetVertexCount(),
+    timeMean, Percentile(times, 0.5), Percentile(times, 0.9), Percentile(times, 0.99), sum.Length());
+}
+
+static void BenchmarkPair(BenchmarkShape& shapeA, BenchmarkShape& shapeB, FILE* file)
+{
+  // Deeply overlapping, overlapping, just apart and far apart (the shapes are all about unit radius)
+  const float centerDistances[] = { 0.5f, 1.5f, 2.1f, 4.0f };
+  const unsigned int maxIterations[] = { 4, 16, 64 };
+
+  BenchmarkComputeSupport(shapeA, shapeB, file);
+  for (size_t d = 0; d < sizeof(centerDistances) / sizeof(centerDistances[0]); ++d)
+  {
+    for (size_t m = 0; m < sizeof(maxIterations) / sizeof(maxIterations[0]); ++m)
+    {
+      BenchmarkIntersect(shapeA, shapeB, centerDistances[d], maxIterations[m], file);
+    }
+  }
+}
+
+void RunGjkBenchmarks(FILE* file)
+{
+  fprintf(file, "# gjk benchmarks: %zu poses per intersect case, %zu x %zu directions per support case, times in ns\n",
+    cBenchmarkPoses, cSupportSamples, cSupportBatch);
+
+  SphereBenchmarkShape sphereA, sphereB;
+  ObbBenchmarkShape obbA, obbB;
+  BenchmarkPair(sphereA, sphereB, file);
+  BenchmarkPair(obbA, obbB, file);
+  BenchmarkPair(sphereA, obbB, file);
+
+  // uv-sphere resolutions giving 26, 242 and 1922 vertices
+  const size_t rings[] = { 3, 10, 30 };
+  const size_t segments[] = { 8, 24, 64 };
+  for (size_t i = 0; i < sizeof(rings) / sizeof(rings[0]); ++i)
+  {
+    Mesh mesh;
+    BuildSphereMesh(rings[i], segments[i], mesh);
+
+    PointsBenchmarkShape pointsA(mesh), pointsB(mesh);
+    BenchmarkPair(pointsA, obbB, file);
+    BenchmarkPair(pointsA, pointsB, file);
+
+    // The mesh pairs a model pair would run, without the models
+    MeshBenchmarkShape climbA(mesh, true), climbB(mesh, true);
+    MeshBenchmarkShape simdA(mesh, false), simdB(mesh, false);
+    BenchmarkPair(climbA, obbB, file);
+    BenchmarkPair(climbA, climbB, file);
+    BenchmarkPair(simdA, simdB, file);
+
+#ifndef GJK_BENCHMARKS_HEADLESS
+    ModelBenchmarkShape modelA(&mesh), modelB(&mesh);
+    BenchmarkPair(modelA, obbB, file);
+    BenchmarkPair(modelA, modelB, file);
+#endif
+  }
+}
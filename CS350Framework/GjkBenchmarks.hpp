@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdio.h>
+
+// Times gjk over canonical shape pairs without creating a window and writes the report to file.
+// Runs from the application's "benchmark [outFile]" argument and from the Benchmarks project.
+void RunGjkBenchmarks(FILE* file);
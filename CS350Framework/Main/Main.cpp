@@ -343,6 +343,27 @@ bool Startup(SDL_Window*& window, SDL_GLContext& glContext, int WindowWidth, int
   return true;
 }
 
+//-----------------------------------------------------------------------------
+// Check to see if the benchmarks should be run ("benchmark [outFile]"). Without an
+// output file the report goes to stdout.
+bool CheckForBenchmarks(int argc, char *argv[])
+{
+  if(argc < 2 || strcmp(argv[1], "benchmark") != 0)
+    return false;
+
+  FILE* file = stdout;
+  if(argc >= 3 && argv[2] != NULL)
+    fopen_s(&file, argv[2], "w");
+  if(file == NULL)
+    return true;
+
+  RunGjkBenchmarks(file);
+
+  if(file != stdout)
+    fclose(file);
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 // Check to see if any unit tests should be run
 bool CheckForUnitTests(int argc, char *argv[])
@@ -416,7 +437,9 @@ int main(int argc, char *argv[])
   //_clearfp();
   //_controlfp_s(&currState, _EM_INEXACT | _EM_UNDERFLOW, _MCW_EM);
 
-  // If we ran unit tests then just exit
+  // If we ran the benchmarks or unit tests then just exit
+  if(CheckForBenchmarks(argc, argv))
+    return 0;
   if(CheckForUnitTests(argc, argv))
     return 0;
 
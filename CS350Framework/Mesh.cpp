@@ -1,3 +1,310 @@
 #include "Precompiled.hpp"
 
 #include "Mesh.hpp"
+#include <set>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+// msvc emits avx intrinsics without /arch:AVX2, the kernel is only called after checking cpuid
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+void Mesh::BuildAdjacency()
+{
+  mHasAdjacency = false;
+  mWeldedVertices.clear();
+  mAdjacencyOffsets.clear();
+  mAdjacency.clear();
+
+  size_t vertexCount = mVertices.size();
+  if(vertexCount == 0 || mIndices.empty())
+    return;
+
+  Aabb aabb;
+  for(size_t i = 0; i < vertexCount; ++i)
+    aabb.Expand(mVertices[i]);
+  float epsilon = 1e-4f * (aabb.GetMax() - aabb.GetMin()).Length();
+
+  // Weld vertices closer than a tenth of epsilon (seams are rarely bit-exact). Sorting on x means
+  // only the following vertices within the tolerance on x have to be checked.
+  float weldEpsilon = 0.1f * epsilon;
+  Indices sorted(vertexCount);
+  for(size_t i = 0; i < vertexCount; ++i)
+    sorted[i] = i;
+  std::sort(sorted.begin(), sorted.end(), [this](size_t lhs, size_t rhs)
+  {
+    return mVertices[lhs].x < mVertices[rhs].x;
+  });
+
+  mWeldedVertices.assign(vertexCount, vertexCount);
+  for(size_t i = 0; i < vertexCount; ++i)
+  {
+    size_t vertex = sorted[i];
+    if(mWeldedVertices[vertex] != vertexCount)
+      continue;
+
+    mWeldedVertices[vertex] = vertex;
+    for(size_t j = i + 1; j < vertexCount && mVertices[sorted[j]].x - mVertices[vertex].x <= weldEpsilon; ++j)
+    {
+      size_t other = sorted[j];
+      if(mWeldedVertices[other] == vertexCount && Math::Distance(mVertices[other], mVertices[vertex]) <= weldEpsilon)
+        mWeldedVertices[other] = vertex;
+    }
+  }
+
+  // A vertex no triangle references can't be reached by climbing, so the scan is required
+  std::vector<bool> referenced(vertexCount, false);
+  for(size_t i = 0; i < mIndices.size(); ++i)
+    referenced[mWeldedVertices[mIndices[i]]] = true;
+  for(size_t i = 0; i < vertexCount; ++i)
+  {
+    if(!referenced[mWeldedVertices[i]])
+      return;
+  }
+
+  // Convexity check: every vertex has to be on one side of each triangle's plane (either winding is accepted)
+  for(size_t t = 0; t < TriangleCount(); ++t)
+  {
+    Triangle tri = TriangleAt(t);
+    Vector3 normal = Math::Cross(tri.mPoints[1] - tri.mPoints[0], tri.mPoints[2] - tri.mPoints[0]);
+    // Slivers don't have a reliable plane
+    float length = normal.Length();
+    if(length < epsilon * epsilon)
+      continue;
+    normal /= length;
+
+    bool front = false;
+    bool back = false;
+    for(size_t i = 0; i < vertexCount; ++i)
+    {
+      float distance = Math::Dot(normal, mVertices[i] - tri.mPoints[0]);
+      front |= distance > epsilon;
+      back |= distance < -epsilon;
+    }
+    if(front && back)
+      return;
+  }
+
+  // Collect the unique welded edges of every triangle
+  std::vector<std::set<size_t> > neighbors(vertexCount);
+  for(size_t i = 0; i < mIndices.size(); i += 3)
+  {
+    for(size_t j = 0; j < 3; ++j)
+    {
+      size_t v0 = mWeldedVertices[mIndices[i + j]];
+      size_t v1 = mWeldedVertices[mIndices[i + (j + 1) % 3]];
+      if(v0 == v1)
+        continue;
+      neighbors[v0].insert(v1);
+      neighbors[v1].insert(v0);
+    }
+  }
+
+  mAdjacencyOffsets.resize(vertexCount + 1);
+  for(size_t i = 0; i < vertexCount; ++i)
+  {
+    mAdjacencyOffsets[i] = mAdjacency.size();
+    mAdjacency.insert(mAdjacency.end(), neighbors[i].begin(), neighbors[i].end());
+  }
+  mAdjacencyOffsets[vertexCount] = mAdjacency.size();
+  mHasAdjacency = true;
+}
+
+size_t Mesh::HillClimb(const Vector3& localDirection, size_t startVertex) const
+{
+  size_t current = mWeldedVertices[startVertex];
+  float maxDot = Math::Dot(mVertices[current], localDirection);
+
+  // On a convex mesh the first vertex with no better neighbor is the global maximum
+  bool improved = true;
+  while(improved)
+  {
+    improved = false;
+    size_t end = mAdjacencyOffsets[current + 1];
+    for(size_t i = mAdjacencyOffsets[current]; i < end; ++i)
+    {
+      size_t neighbor = mAdjacency[i];
+      float dot = Math::Dot(mVertices[neighbor], localDirection);
+      if(maxDot < dot)
+      {
+        maxDot = dot;
+        current = neighbor;
+        improved = true;
+      }
+    }
+  }
+  return current;
+}
+
+//-----------------------------------------------------------------------------Max dot kernels
+// Every kernel returns the lowest index holding the largest dot product (same as a scalar
+// scan with a strictly greater compare) so the choice of kernel never changes the result.
+typedef size_t (*MaxDotKernel)(const float* xs, const float* ys, const float* zs, size_t paddedCount, const Vector3& direction);
+
+static size_t MaxDotScalar(const float* xs, const float* ys, const float* zs, size_t paddedCount, const Vector3& direction)
+{
+  size_t maxIndex = 0;
+  float maxDot = -std::numeric_limits<float>::max();
+  for(size_t i = 0; i < paddedCount; ++i)
+  {
+    float dot = xs[i] * direction.x + ys[i] * direction.y + zs[i] * direction.z;
+    if(maxDot < dot)
+    {
+      maxDot = dot;
+      maxIndex = i;
+    }
+  }
+  return maxIndex;
+}
+
+// Reduces the per lane maxima, ties go to the lower index
+static size_t ReduceLanes(const float* dots, const int* indices, size_t laneCount)
+{
+  size_t best = 0;
+  for(size_t i = 1; i < laneCount; ++i)
+  {
+    if(dots[best] < dots[i] || (dots[best] == dots[i] && indices[i] < indices[best]))
+      best = i;
+  }
+  return static_cast<size_t>(indices[best]);
+}
+
+static size_t MaxDotSse(const float* xs, const float* ys, const float* zs, size_t paddedCount, const Vector3& direction)
+{
+  const __m128 dx = _mm_set1_ps(direction.x);
+  const __m128 dy = _mm_set1_ps(direction.y);
+  const __m128 dz = _mm_set1_ps(direction.z);
+  const __m128i step = _mm_set1_epi32(4);
+  __m128 maxDots = _mm_set1_ps(-std::numeric_limits<float>::max());
+  __m128i maxIndices = _mm_setzero_si128();
+  __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+
+  for(size_t i = 0; i < paddedCount; i += 4)
+  {
+    __m128 dots = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(xs + i), dx), _mm_mul_ps(_mm_loadu_ps(ys + i), dy)), _mm_mul_ps(_mm_loadu_ps(zs + i), dz));
+    // Strictly greater keeps the earliest index within each lane
+    __m128 greater = _mm_cmpgt_ps(dots, maxDots);
+    __m128i mask = _mm_castps_si128(greater);
+    maxDots = _mm_or_ps(_mm_and_ps(greater, dots), _mm_andnot_ps(greater, maxDots));
+    maxIndices = _mm_or_si128(_mm_and_si128(mask, indices), _mm_andnot_si128(mask, maxIndices));
+    indices = _mm_add_epi32(indices, step);
+  }
+
+  float dots[4];
+  int lanes[4];
+  _mm_storeu_ps(dots, maxDots);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), maxIndices);
+  return ReduceLanes(dots, lanes, 4);
+}
+
+static SIMD_TARGET_AVX2 size_t MaxDotAvx2(const float* xs, const float* ys, const float* zs, size_t paddedCount, const Vector3& direction)
+{
+  const __m256 dx = _mm256_set1_ps(direction.x);
+  const __m256 dy = _mm256_set1_ps(direction.y);
+  const __m256 dz = _mm256_set1_ps(direction.z);
+  const __m256i step = _mm256_set1_epi32(8);
+  __m256 maxDots = _mm256_set1_ps(-std::numeric_limits<float>::max());
+  __m256i maxIndices = _mm256_setzero_si256();
+  __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for(size_t i = 0; i < paddedCount; i += 8)
+  {
+    // No fma so the dot products round exactly like the other kernels
+    __m256 dots = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(xs + i), dx), _mm256_mul_ps(_mm256_loadu_ps(ys + i), dy)), _mm256_mul_ps(_mm256_loadu_ps(zs + i), dz));
+    __m256 greater = _mm256_cmp_ps(dots, maxDots, _CMP_GT_OQ);
+    maxDots = _mm256_blendv_ps(maxDots, dots, greater);
+    maxIndices = _mm256_blendv_epi8(maxIndices, indices, _mm256_castps_si256(greater));
+    indices = _mm256_add_epi32(indices, step);
+  }
+
+  float dots[8];
+  int lanes[8];
+  _mm256_storeu_ps(dots, maxDots);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), maxIndices);
+  return ReduceLanes(dots, lanes, 8);
+}
+
+static bool CpuSupportsSse2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+
+static bool CpuSupportsAvx2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if(info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  // The os has to save the ymm registers (osxsave + xgetbv) as well as the cpu having avx
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if(!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+static MaxDotKernel SelectMaxDotKernel()
+{
+  if(CpuSupportsAvx2())
+    return MaxDotAvx2;
+  if(CpuSupportsSse2())
+    return MaxDotSse;
+  return MaxDotScalar;
+}
+
+//-----------------------------------------------------------------------------Mesh
+void Mesh::BuildSoaVertices()
+{
+  mSoaCount = mVertices.size();
+  size_t paddedCount = (mSoaCount + 7) & ~static_cast<size_t>(7);
+  mSoaX.resize(paddedCount);
+  mSoaY.resize(paddedCount);
+  mSoaZ.resize(paddedCount);
+  for(size_t i = 0; i < paddedCount; ++i)
+  {
+    // Padding repeats the last vertex, it can only tie with it and ties keep the lower index
+    const Vector3& vertex = mVertices[Math::Min(i, mSoaCount - 1)];
+    mSoaX[i] = vertex.x;
+    mSoaY[i] = vertex.y;
+    mSoaZ[i] = vertex.z;
+  }
+}
+
+size_t Mesh::MaxDotVertex(const Vector3& localDirection) const
+{
+  static const MaxDotKernel kernel = SelectMaxDotKernel();
+  if(!HasSoaVertices())
+  {
+    // Stale or missing copy, scan the vertices directly
+    size_t maxIndex = 0;
+    float maxDot = -std::numeric_limits<float>::max();
+    for(size_t i = 0; i < mVertices.size(); ++i)
+    {
+      float dot = Math::Dot(mVertices[i], localDirection);
+      if(maxDot < dot)
+      {
+        maxDot = dot;
+        maxIndex = i;
+      }
+    }
+    return maxIndex;
+  }
+  return kernel(&mSoaX[0], &mSoaY[0], &mSoaZ[0], mSoaX.size(), localDirection);
+}
@@ -13,12 +13,14 @@
 class Mesh
 {
 public:
-  Mesh() { mDynamic = false; mType = 0; }
+  Mesh() { mDynamic = false; mType = 0; mHasAdjacency = false; mSoaCount = 0; }
   Mesh(const std::string& name, int type)
   {
     mName = name;
     mDynamic = false;
     mType = type;
+    mHasAdjacency = false;
+    mSoaCount = 0;
   }
 
   size_t TriangleCount() const
@@ -35,11 +37,39 @@ public:
     return tri;
   }
 
+  // Builds the vertex adjacency graph used for hill-climbing support queries. Coincident vertices are
+  // welded so seams don't split the graph. The graph is only kept for convex meshes since the climb
+  // can stall on a local maximum otherwise. Call again whenever the vertices or indices change.
+  void BuildAdjacency();
+  bool HasAdjacency() const { return mHasAdjacency; }
+  // Walks the adjacency graph from startVertex to the vertex furthest along the local direction.
+  size_t HillClimb(const Vector3& localDirection, size_t startVertex) const;
+
+  // Copies the vertices into the x/y/z arrays scanned by MaxDotVertex. Call again whenever the vertices change.
+  void BuildSoaVertices();
+  bool HasSoaVertices() const { return mSoaCount != 0 && mSoaCount == mVertices.size(); }
+  // Index of the first vertex furthest along the local direction. Uses the widest
+  // simd kernel the cpu supports (picked once through cpuid) with a scalar fallback.
+  size_t MaxDotVertex(const Vector3& localDirection) const;
+
   typedef std::vector<Vector3> Vertices;
   Vertices mVertices;
   typedef std::vector<size_t> Indices;
   Indices mIndices;
 
+  // Welded vertex index for each vertex (only welded vertices have neighbors).
+  Indices mWeldedVertices;
+  // The neighbors of vertex i are mAdjacency[mAdjacencyOffsets[i]] up to mAdjacency[mAdjacencyOffsets[i + 1]].
+  Indices mAdjacencyOffsets;
+  Indices mAdjacency;
+  bool mHasAdjacency;
+
+  // Structure of arrays copy of mVertices padded to a multiple of 8 by repeating the last vertex.
+  std::vector<float> mSoaX;
+  std::vector<float> mSoaY;
+  std::vector<float> mSoaZ;
+  size_t mSoaCount;
+
   std::string mName;
   bool mDynamic;
   int mType;
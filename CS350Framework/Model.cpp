@@ -12,8 +12,14 @@
 #include "Geometry.hpp"
 #include "DebugDraw.hpp"
 #include "BspTree.hpp"
+#include "Gjk.hpp"
 #include "SimplePropertyBinding.hpp"
 
+// Gjk ray casts against convex models. The epsilon is relative to the model's size, so large models converge as
+// readily as small ones and small ones aren't stopped short.
+static const unsigned int cRayCastMaxIterations = 64;
+static const float cRayCastRelativeEpsilon = 0.0001f;
+
 //-----------------------------------------------------------------------------Model
 Model::Model()
 {
@@ -138,6 +144,31 @@ bool Model::CastRayMidphase(const Ray& localRay, CastResult& castInfo)
 
 bool Model::CastRay(const Ray& worldRay, CastResult& castInfo)
 {
+  // Only convex meshes keep an adjacency graph, those can be cast against with a few support calls instead of every triangle.
+  // A ray starting inside the mesh hits the solid at t = 0, so that case still goes through the triangles to find where it leaves.
+  // So does a cast that runs out of iterations, since it can't tell a miss from a slow hit.
+  if(mMesh->HasAdjacency())
+  {
+    ModelSupportShape shape;
+    shape.mModel = this;
+    shape.GatherTransform();
+    Aabb bounds = shape.GetAabb();
+    float epsilon = cRayCastRelativeEpsilon * (bounds.mMax - bounds.mMin).Length();
+
+    Gjk gjk;
+    float t;
+    Vector3 normal;
+    bool hit = gjk.RayCast(&shape, worldRay, Math::PositiveMax(), cRayCastMaxIterations, epsilon, t, normal);
+    if(!hit && gjk.mStatistics.mMaxIterationExits == 0)
+      return false;
+
+    if(hit && t > 0.0f)
+    {
+      castInfo.mTime = t;
+      return true;
+    }
+  }
+
   Math::Matrix4 toWorldMat = mOwner->has(Transform)->GetTransform();
   Math::Matrix4 toLocalMat = toWorldMat.Inverted();
 
@@ -295,4 +326,6 @@ void Model::SetWorldTriangles(const std::vector<Triangle>& tris)
     mMesh->mVertices.push_back(p1);
     mMesh->mVertices.push_back(p2);
   }
+  mMesh->BuildAdjacency();
+  mMesh->BuildSoaVertices();
 }
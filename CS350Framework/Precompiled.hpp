@@ -30,6 +30,7 @@
 #include "Geometry.hpp"
 #include "Gizmo.hpp"
 #include "Gjk.hpp"
+#include "GjkBenchmarks.hpp"
 #include "Main/Support.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
@@ -38,3 +39,4 @@
 #include "SimplePropertyBinding.hpp"
 #include "SpatialPartition.hpp"
 #include "UnitTests.hpp"
+#include "WorkerPool.hpp"
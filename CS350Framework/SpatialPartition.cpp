@@ -14,6 +14,9 @@
 SpatialPartitionKey::SpatialPartitionKey()
 {
   mVoidKey = NULL;
+  // Index 0 is a real slot for partitions that key by index, so a key that was never
+  // inserted holds the invalid index instead (DynamicAabbTree's Node::cNullNode)
+  mUIntKey = 0xFFFFFFFF;
 }
 
 //-----------------------------------------------------------------------------SpatialPartitionData
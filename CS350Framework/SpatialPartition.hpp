@@ -9,6 +9,8 @@
 #include "Shapes.hpp"
 #include <vector>
 
+class SupportShape;
+
 //-----------------------------------------------------------------------------SpatialPartitionKey
 // This class is used for uniquely identifying (and quick finding) of any object
 // in a spatial partition. When an object is inserted into the spatial partition
@@ -21,6 +23,7 @@ public:
 
   // Most spatial partitions can get away with a pointer or an integer.
   // Use whichever makes the most sense for your spatial partition.
+  // A default constructed key has mUIntKey set to 0xFFFFFFFF (mVoidKey is only meaningful once a partition sets it).
   union
   {
     void* mVoidKey;
@@ -154,6 +157,9 @@ public:
   // bit loose (as accurate frustum tests can be a bit expensive).
   // Also the CastResult's time should be set to 0.
   virtual void CastFrustum(const Frustum& frustum, CastResults& results) = 0;
+  // Finds out what objects in the spatial partition are hit by the shape moved along the sweep.
+  // The CastResult's time is the fraction of the sweep where the shape first touches the object's bounding volume.
+  virtual void CastShape(const SupportShape& shape, const Vector3& sweep, CastResults& results) = 0;
 
   // Returns pairs of all objects that are overlapping in this spatial partition.
   // This represents what physics might do to determine overlapping pairs.
@@ -0,0 +1,106 @@
+#include "Precompiled.hpp"
+
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(int threadCount)
+{
+  mFunction = nullptr;
+  mCount = 0;
+  mChunkSize = 1;
+  mNextChunk = 0;
+  mBusyWorkers = 0;
+  mGeneration = 0;
+  mQuit = false;
+
+  if(threadCount < 0)
+  {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    threadCount = hardwareThreads > 1 ? static_cast<int>(hardwareThreads) - 1 : 0;
+  }
+
+  for(int i = 0; i < threadCount; ++i)
+    mThreads.push_back(std::thread(&WorkerPool::WorkerLoop, this, static_cast<size_t>(i + 1)));
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQuit = true;
+  }
+  mWakeWorkers.notify_all();
+  for(size_t i = 0; i < mThreads.size(); ++i)
+    mThreads[i].join();
+}
+
+size_t WorkerPool::GetWorkerCount() const
+{
+  return mThreads.size() + 1;
+}
+
+void WorkerPool::ParallelFor(size_t count, size_t chunkSize, const RangeFunction& function)
+{
+  if(chunkSize == 0)
+    chunkSize = 1;
+  if(count == 0)
+    return;
+  if(mThreads.empty() || count <= chunkSize)
+  {
+    function(0, count, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFunction = &function;
+    mCount = count;
+    mChunkSize = chunkSize;
+    mNextChunk = 0;
+    mBusyWorkers = mThreads.size();
+    ++mGeneration;
+  }
+  mWakeWorkers.notify_all();
+
+  RunChunks(0);
+
+  // Chunks are handed out dynamically so a worker that wakes late may find nothing left,
+  // but every worker has to check in before the function can go out of scope.
+  std::unique_lock<std::mutex> lock(mMutex);
+  mWorkersDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+  mFunction = nullptr;
+}
+
+void WorkerPool::WorkerLoop(size_t workerIndex)
+{
+  size_t generation = 0;
+  for(;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeWorkers.wait(lock, [this, generation]() { return mQuit || mGeneration != generation; });
+      if(mQuit)
+        return;
+      generation = mGeneration;
+    }
+
+    RunChunks(workerIndex);
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      --mBusyWorkers;
+    }
+    mWorkersDone.notify_one();
+  }
+}
+
+void WorkerPool::RunChunks(size_t workerIndex)
+{
+  for(;;)
+  {
+    size_t begin = mNextChunk.fetch_add(mChunkSize);
+    if(begin >= mCount)
+      return;
+    size_t end = begin + mChunkSize < mCount ? begin + mChunkSize : mCount;
+    (*mFunction)(begin, end, workerIndex);
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that split a range of work between them. The calling thread
+// works alongside the pool, so a pool with no threads just runs everything inline.
+class WorkerPool
+{
+public:
+  // Called with a chunk [begin, end) and the index of the worker running it (0 is the calling thread).
+  typedef std::function<void(size_t begin, size_t end, size_t workerIndex)> RangeFunction;
+
+  // A thread count of -1 uses one less than the hardware threads (the caller is the last one).
+  explicit WorkerPool(int threadCount = -1);
+  ~WorkerPool();
+
+  // The number of workers that can run chunks including the calling thread.
+  size_t GetWorkerCount() const;
+  // Runs the function over [0, count) in chunks of chunkSize and returns once every chunk has finished.
+  // Ranges no bigger than a chunk run inline without waking the pool.
+  void ParallelFor(size_t count, size_t chunkSize, const RangeFunction& function);
+
+private:
+  void WorkerLoop(size_t workerIndex);
+  void RunChunks(size_t workerIndex);
+
+  std::vector<std::thread> mThreads;
+  std::mutex mMutex;
+  std::condition_variable mWakeWorkers;
+  std::condition_variable mWorkersDone;
+
+  // The job currently being run (only valid between waking the workers and them all finishing)
+  const RangeFunction* mFunction;
+  size_t mCount;
+  size_t mChunkSize;
+  std::atomic<size_t> mNextChunk;
+  size_t mBusyWorkers;
+  size_t mGeneration;
+  bool mQuit;
+};